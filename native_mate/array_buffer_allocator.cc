@@ -0,0 +1,128 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/array_buffer_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace mate {
+
+PooledArrayBufferAllocator::PooledArrayBufferAllocator(size_t max_cached_bytes)
+    : max_cached_bytes_(max_cached_bytes),
+      allocations_(0),
+      pool_hits_(0),
+      frees_(0),
+      bytes_in_use_(0),
+      bytes_cached_(0) {
+}
+
+PooledArrayBufferAllocator::~PooledArrayBufferAllocator() {
+  Trim();
+}
+
+void* PooledArrayBufferAllocator::Allocate(size_t length) {
+  return AllocateImpl(length, true);
+}
+
+void* PooledArrayBufferAllocator::AllocateUninitialized(size_t length) {
+  return AllocateImpl(length, false);
+}
+
+void PooledArrayBufferAllocator::Free(void* data, size_t length) {
+  if (!data)
+    return;
+  frees_.fetch_add(1, std::memory_order_relaxed);
+
+  int size_class = GetSizeClass(length);
+  if (size_class < 0) {
+    bytes_in_use_.fetch_sub(length, std::memory_order_relaxed);
+    free(data);
+    return;
+  }
+
+  size_t size = static_cast<size_t>(1) << (size_class + kMinClassShift);
+  bytes_in_use_.fetch_sub(size, std::memory_order_relaxed);
+  if (bytes_cached_.load(std::memory_order_relaxed) + size <=
+      max_cached_bytes_) {
+    SizeClass& pool = classes_[size_class];
+    base::AutoLock auto_lock(pool.lock);
+    pool.blocks.push_back(data);
+    bytes_cached_.fetch_add(size, std::memory_order_relaxed);
+    return;
+  }
+  free(data);
+}
+
+void PooledArrayBufferAllocator::Trim() {
+  for (int i = 0; i < kClassCount; ++i) {
+    std::vector<void*> blocks;
+    {
+      base::AutoLock auto_lock(classes_[i].lock);
+      blocks.swap(classes_[i].blocks);
+    }
+    size_t size = static_cast<size_t>(1) << (i + kMinClassShift);
+    bytes_cached_.fetch_sub(size * blocks.size(), std::memory_order_relaxed);
+    for (size_t j = 0; j < blocks.size(); ++j)
+      free(blocks[j]);
+  }
+}
+
+ArrayBufferAllocatorStats PooledArrayBufferAllocator::GetStats() const {
+  ArrayBufferAllocatorStats stats;
+  stats.allocations = allocations_.load(std::memory_order_relaxed);
+  stats.pool_hits = pool_hits_.load(std::memory_order_relaxed);
+  stats.frees = frees_.load(std::memory_order_relaxed);
+  stats.bytes_in_use = bytes_in_use_.load(std::memory_order_relaxed);
+  stats.bytes_cached = bytes_cached_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+// static
+int PooledArrayBufferAllocator::GetSizeClass(size_t length) {
+  if (length > (static_cast<size_t>(1) << kMaxClassShift))
+    return -1;
+  int shift = kMinClassShift;
+  while ((static_cast<size_t>(1) << shift) < length)
+    ++shift;
+  return shift - kMinClassShift;
+}
+
+void* PooledArrayBufferAllocator::AllocateImpl(size_t length, bool zero) {
+  allocations_.fetch_add(1, std::memory_order_relaxed);
+
+  int size_class = GetSizeClass(length);
+  if (size_class < 0) {
+    void* data = zero ? calloc(length, 1) : malloc(length);
+    if (data)
+      bytes_in_use_.fetch_add(length, std::memory_order_relaxed);
+    return data;
+  }
+
+  size_t size = static_cast<size_t>(1) << (size_class + kMinClassShift);
+  void* data = NULL;
+  {
+    SizeClass& pool = classes_[size_class];
+    base::AutoLock auto_lock(pool.lock);
+    if (!pool.blocks.empty()) {
+      data = pool.blocks.back();
+      pool.blocks.pop_back();
+    }
+  }
+
+  if (data) {
+    pool_hits_.fetch_add(1, std::memory_order_relaxed);
+    bytes_cached_.fetch_sub(size, std::memory_order_relaxed);
+    if (zero)
+      memset(data, 0, length);
+  } else {
+    data = zero ? calloc(size, 1) : malloc(size);
+    if (!data)
+      return NULL;
+  }
+  bytes_in_use_.fetch_add(size, std::memory_order_relaxed);
+  return data;
+}
+
+}  // namespace mate
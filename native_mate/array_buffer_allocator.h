@@ -0,0 +1,93 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_ARRAY_BUFFER_ALLOCATOR_H_
+#define NATIVE_MATE_ARRAY_BUFFER_ALLOCATOR_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/synchronization/lock.h"
+#include "native_mate/struct_converter.h"
+#include "v8/include/v8.h"
+
+namespace mate {
+
+// Counters of a PooledArrayBufferAllocator, read with GetStats().
+struct ArrayBufferAllocatorStats {
+  ArrayBufferAllocatorStats()
+      : allocations(0), pool_hits(0), frees(0), bytes_in_use(0),
+        bytes_cached(0) {}
+
+  uint64_t allocations;
+  uint64_t pool_hits;
+  uint64_t frees;
+  uint64_t bytes_in_use;
+  uint64_t bytes_cached;
+};
+
+// PooledArrayBufferAllocator is a v8::ArrayBuffer::Allocator that keeps freed
+// blocks of up to 1 MB in power of two size classes and reuses them, so
+// short-lived buffers do not go through malloc and free each time. Blocks
+// are only zeroed when V8 asks for initialized memory. At most
+// |max_cached_bytes| are kept in the free lists, larger blocks and blocks
+// over the limit are returned to the system.
+//
+// It is thread safe, the same allocator can be shared by several isolates
+// and used by native threads through BackingStore::Allocate.
+class PooledArrayBufferAllocator : public v8::ArrayBuffer::Allocator {
+ public:
+  explicit PooledArrayBufferAllocator(size_t max_cached_bytes = 64 << 20);
+  ~PooledArrayBufferAllocator() override;
+
+  // v8::ArrayBuffer::Allocator:
+  void* Allocate(size_t length) override;
+  void* AllocateUninitialized(size_t length) override;
+  void Free(void* data, size_t length) override;
+
+  // Returns the cached blocks to the system.
+  void Trim();
+
+  ArrayBufferAllocatorStats GetStats() const;
+
+ private:
+  static const int kMinClassShift = 6;
+  static const int kMaxClassShift = 20;
+  static const int kClassCount = kMaxClassShift - kMinClassShift + 1;
+
+  struct SizeClass {
+    base::Lock lock;
+    std::vector<void*> blocks;
+  };
+
+  // Returns the size class of |length|, or -1 if it is not pooled.
+  static int GetSizeClass(size_t length);
+
+  void* AllocateImpl(size_t length, bool zero);
+
+  const size_t max_cached_bytes_;
+  SizeClass classes_[kClassCount];
+
+  std::atomic<uint64_t> allocations_;
+  std::atomic<uint64_t> pool_hits_;
+  std::atomic<uint64_t> frees_;
+  std::atomic<uint64_t> bytes_in_use_;
+  std::atomic<uint64_t> bytes_cached_;
+
+  DISALLOW_COPY_AND_ASSIGN(PooledArrayBufferAllocator);
+};
+
+}  // namespace mate
+
+MATE_STRUCT(mate::ArrayBufferAllocatorStats,
+            MATE_FIELD(allocations, "allocations"),
+            MATE_FIELD(pool_hits, "poolHits"),
+            MATE_FIELD(frees, "frees"),
+            MATE_FIELD(bytes_in_use, "bytesInUse"),
+            MATE_FIELD(bytes_cached, "bytesCached"))
+
+#endif  // NATIVE_MATE_ARRAY_BUFFER_ALLOCATOR_H_
@@ -0,0 +1,73 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/ascii_util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MATE_ASCII_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MATE_ASCII_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+const uint64_t kHighBits = 0x8080808080808080ULL;
+
+bool IsAsciiScalar(const char* data, size_t length) {
+  size_t i = 0;
+  uint64_t bits = 0;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, sizeof(word));
+    bits |= word;
+    // Stop at the first 64-byte block with a non-ASCII byte, like the SIMD
+    // loops.
+    if ((i & 56) == 56 && (bits & kHighBits) != 0)
+      return false;
+  }
+  for (; i < length; ++i)
+    bits |= static_cast<unsigned char>(data[i]);
+  return (bits & kHighBits) == 0;
+}
+
+}  // namespace
+
+bool IsAscii(const char* data, size_t length) {
+  size_t i = 0;
+#if defined(MATE_ASCII_SSE2)
+  for (; i + 64 <= length; i += 64) {
+    const __m128i* block = reinterpret_cast<const __m128i*>(data + i);
+    __m128i bits = _mm_or_si128(
+        _mm_or_si128(_mm_loadu_si128(block), _mm_loadu_si128(block + 1)),
+        _mm_or_si128(_mm_loadu_si128(block + 2), _mm_loadu_si128(block + 3)));
+    if (_mm_movemask_epi8(bits) != 0)
+      return false;
+  }
+#elif defined(MATE_ASCII_NEON)
+  for (; i + 64 <= length; i += 64) {
+    const uint8_t* block = reinterpret_cast<const uint8_t*>(data + i);
+    uint8x16_t bits = vorrq_u8(vorrq_u8(vld1q_u8(block), vld1q_u8(block + 16)),
+                               vorrq_u8(vld1q_u8(block + 32),
+                                        vld1q_u8(block + 48)));
+    uint8x8_t half = vorr_u8(vget_low_u8(bits), vget_high_u8(bits));
+    if (vget_lane_u64(vreinterpret_u64_u8(half), 0) & kHighBits)
+      return false;
+  }
+#endif
+  return IsAsciiScalar(data + i, length - i);
+}
+
+}  // namespace internal
+
+}  // namespace mate
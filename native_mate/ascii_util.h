@@ -0,0 +1,26 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_ASCII_UTIL_H_
+#define NATIVE_MATE_ASCII_UTIL_H_
+
+#include <stddef.h>
+
+namespace mate {
+
+namespace internal {
+
+// Returns whether the |length| bytes at |data| are all ASCII, in which case
+// the UTF-8 text is also valid Latin-1 and V8 can copy it into a one-byte
+// string without decoding it. Scans 64 bytes at a time with SSE2 or NEON
+// where available, and 8 bytes at a time otherwise. The scan stops at the
+// first 64-byte block with a non-ASCII byte, so text that then goes through
+// the UTF-8 decoder is only scanned twice up to that block.
+bool IsAscii(const char* data, size_t length);
+
+}  // namespace internal
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_ASCII_UTIL_H_
@@ -0,0 +1,137 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/async_iterator.h"
+
+#include "native_mate/iterator.h"
+#include "native_mate/object_template_builder.h"
+#include "native_mate/per_isolate_data.h"
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+// Address of the async iterator template in PerIsolateData.
+const char kAsyncIteratorTemplateKey = 0;
+
+// Returns Symbol.asyncIterator, which V8 has no API for.
+v8::Local<v8::Value> GetAsyncIteratorSymbol(v8::Isolate* isolate) {
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Value> symbol;
+  v8::Local<v8::Value> async_iterator;
+  if (!context->Global()->Get(context, StringToSymbol(isolate, "Symbol"))
+           .ToLocal(&symbol) ||
+      !symbol->IsObject() ||
+      !v8::Local<v8::Object>::Cast(symbol)
+           ->Get(context, StringToSymbol(isolate, "asyncIterator"))
+           .ToLocal(&async_iterator))
+    return v8::Local<v8::Value>();
+  return async_iterator;
+}
+
+}  // namespace
+
+AsyncIteratorBase::AsyncIteratorBase() {
+}
+
+AsyncIteratorBase::~AsyncIteratorBase() {
+  keep_alive_.Reset();
+}
+
+void AsyncIteratorBase::ResolveNext(v8::Local<v8::Context> context,
+                                    v8::Local<v8::Value> value) {
+  if (pending_.empty())
+    return;
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::Local<v8::Promise::Resolver> resolver =
+      v8::Local<v8::Promise::Resolver>::New(isolate, pending_.front());
+  pending_.pop_front();
+  ignore_result(resolver->Resolve(
+      context, NewIteratorResult(isolate, value, false)));
+  if (pending_.empty())
+    keep_alive_.Reset();
+}
+
+void AsyncIteratorBase::ResolveAllDone(v8::Local<v8::Context> context) {
+  v8::Isolate* isolate = context->GetIsolate();
+  while (!pending_.empty()) {
+    v8::Local<v8::Promise::Resolver> resolver =
+        v8::Local<v8::Promise::Resolver>::New(isolate, pending_.front());
+    pending_.pop_front();
+    ignore_result(resolver->Resolve(
+        context, NewIteratorResult(isolate, MATE_UNDEFINED(isolate), true)));
+  }
+  keep_alive_.Reset();
+}
+
+ObjectTemplateBuilder AsyncIteratorBase::GetObjectTemplateBuilder(
+    v8::Isolate* isolate) {
+  PerIsolateData* data = PerIsolateData::From(isolate);
+  v8::Local<v8::ObjectTemplate> templ =
+      data->GetObjectTemplate(&kAsyncIteratorTemplateKey);
+  if (templ.IsEmpty()) {
+    templ = ObjectTemplateBuilder(isolate)
+        .SetMethod("next", &AsyncIteratorBase::Next)
+        .SetMethod("return", &AsyncIteratorBase::Return)
+        .Build();
+    v8::Local<v8::Value> symbol = GetAsyncIteratorSymbol(isolate);
+    if (!symbol.IsEmpty() && symbol->IsSymbol())
+      templ->Set(v8::Local<v8::Symbol>::Cast(symbol),
+                 CreateFunctionTemplate(
+                     isolate, base::Bind(&AsyncIteratorBase::GetIterator),
+                     HolderIsFirstArgument));
+    data->SetObjectTemplate(&kAsyncIteratorTemplateKey, templ);
+  }
+  return ObjectTemplateBuilder(isolate, templ);
+}
+
+v8::Local<v8::Object> AsyncIteratorBase::Next(v8::Isolate* isolate) {
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver))
+    return v8::Local<v8::Object>();
+
+  // Values must settle the promises in order, so a next() behind pending
+  // ones waits for the delivery task too.
+  v8::Local<v8::Value> value;
+  switch (Poll(isolate, !pending_.empty(), &value)) {
+    case POLL_VALUE:
+      ignore_result(resolver->Resolve(
+          context, NewIteratorResult(isolate, value, false)));
+      break;
+    case POLL_DONE:
+      ignore_result(resolver->Resolve(
+          context, NewIteratorResult(isolate, MATE_UNDEFINED(isolate), true)));
+      break;
+    case POLL_PENDING:
+      pending_.push_back(
+          v8::UniquePersistent<v8::Promise::Resolver>(isolate, resolver));
+      if (keep_alive_.IsEmpty())
+        keep_alive_.Reset(isolate, GetWrapper(isolate));
+      break;
+  }
+  return resolver->GetPromise();
+}
+
+v8::Local<v8::Object> AsyncIteratorBase::Return(v8::Isolate* isolate) {
+  Cancel();
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  ResolveAllDone(context);
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver))
+    return v8::Local<v8::Object>();
+  ignore_result(resolver->Resolve(
+      context, NewIteratorResult(isolate, MATE_UNDEFINED(isolate), true)));
+  return resolver->GetPromise();
+}
+
+v8::Local<v8::Object> AsyncIteratorBase::GetIterator(v8::Isolate* isolate) {
+  return GetWrapper(isolate);
+}
+
+}  // namespace internal
+
+}  // namespace mate
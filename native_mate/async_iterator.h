@@ -0,0 +1,302 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_ASYNC_ITERATOR_H_
+#define NATIVE_MATE_ASYNC_ITERATOR_H_
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/thread_task_runner_handle.h"
+#include "native_mate/converter.h"
+#include "native_mate/microtasks.h"
+#include "native_mate/wrappable.h"
+
+namespace mate {
+
+template<typename T> class AsyncIterator;
+
+namespace internal {
+
+// The JavaScript side of an AsyncIterator: an object with next(), return()
+// and [Symbol.asyncIterator](). Each next() returns a promise, which is
+// resolved at once when a value is buffered and queued otherwise. The
+// wrapper is kept alive while promises are pending.
+class AsyncIteratorBase : public Wrappable {
+ protected:
+  enum PollResult {
+    POLL_VALUE,
+    POLL_DONE,
+    POLL_PENDING,
+  };
+
+  AsyncIteratorBase();
+  ~AsyncIteratorBase() override;
+
+  // Takes the next value into |value|. When |wait| is true, or nothing is
+  // buffered, it registers a pending next() instead and returns
+  // POLL_PENDING, the value is then passed to ResolveNext later.
+  virtual PollResult Poll(v8::Isolate* isolate,
+                          bool wait,
+                          v8::Local<v8::Value>* value) = 0;
+
+  // Stops the producer, called by return().
+  virtual void Cancel() = 0;
+
+  // Resolves the oldest pending next() with |value|.
+  void ResolveNext(v8::Local<v8::Context> context, v8::Local<v8::Value> value);
+
+  // Resolves all the pending next() as done.
+  void ResolveAllDone(v8::Local<v8::Context> context);
+
+  // Wrappable:
+  ObjectTemplateBuilder GetObjectTemplateBuilder(
+      v8::Isolate* isolate) override;
+
+ private:
+  v8::Local<v8::Object> Next(v8::Isolate* isolate);
+  v8::Local<v8::Object> Return(v8::Isolate* isolate);
+  v8::Local<v8::Object> GetIterator(v8::Isolate* isolate);
+
+  std::deque<v8::UniquePersistent<v8::Promise::Resolver> > pending_;
+
+  // Strong reference to the wrapper while |pending_| is not empty.
+  v8::UniquePersistent<v8::Object> keep_alive_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncIteratorBase);
+};
+
+}  // namespace internal
+
+// AsyncProducer is the native end of an AsyncIterator. A producer thread
+// pushes values and JavaScript consumes them with for await:
+//
+//   scoped_refptr<mate::AsyncProducer<Frame>> producer =
+//       new mate::AsyncProducer<Frame>(64);
+//   decoder_thread->Start(producer);  // Calls Push() then Close().
+//   return mate::AsyncIterator<Frame>::Create(isolate, producer);
+//
+//   for await (const frame of decoder.frames()) { ... }
+//
+// At most |capacity| values are buffered, Push() blocks while the buffer is
+// full so a slow consumer bounds the memory. Values are handed to the
+// isolate thread in batches: one task resolves the pending next() promises
+// with all the values that arrived in the meantime.
+template<typename T>
+class AsyncProducer : public base::RefCountedThreadSafe<AsyncProducer<T> > {
+ public:
+  explicit AsyncProducer(size_t capacity)
+      : capacity_(capacity > 0 ? capacity : 1),
+        not_full_(&lock_),
+        task_runner_(base::ThreadTaskRunnerHandle::Get()),
+        consumer_(NULL),
+        waiting_(0),
+        closed_(false),
+        cancelled_(false),
+        drain_scheduled_(false) {}
+
+  // Queues |value|, waiting while the buffer is full. Returns false when the
+  // iteration has been stopped, the producer should then stop too. Must not
+  // be called on the isolate thread.
+  bool Push(T value) {
+    base::AutoLock auto_lock(lock_);
+    while (items_.size() >= capacity_ && !cancelled_)
+      not_full_.Wait();
+    return PushLocked(std::move(value));
+  }
+
+  // Like Push, but returns false instead of waiting when the buffer is full.
+  bool TryPush(T value) {
+    base::AutoLock auto_lock(lock_);
+    if (items_.size() >= capacity_)
+      return false;
+    return PushLocked(std::move(value));
+  }
+
+  // Ends the iteration once the buffered values are consumed.
+  void Close() {
+    base::AutoLock auto_lock(lock_);
+    closed_ = true;
+    ScheduleDrainLocked();
+  }
+
+  // Whether the consumer has stopped the iteration.
+  bool IsCancelled() {
+    base::AutoLock auto_lock(lock_);
+    return cancelled_;
+  }
+
+ private:
+  friend class base::RefCountedThreadSafe<AsyncProducer>;
+  friend class AsyncIterator<T>;
+
+  ~AsyncProducer() {}
+
+  bool PushLocked(T value) {
+    if (cancelled_ || closed_)
+      return false;
+    items_.push_back(std::move(value));
+    ScheduleDrainLocked();
+    return true;
+  }
+
+  // Posts a delivery when a next() is pending and can be settled.
+  void ScheduleDrainLocked() {
+    if (waiting_ == 0 || drain_scheduled_ || (items_.empty() && !closed_))
+      return;
+    drain_scheduled_ = true;
+    task_runner_->PostTask(FROM_HERE,
+                           base::Bind(&AsyncProducer::Drain, this));
+  }
+
+  // Called on the isolate thread by the consumer.
+  bool Poll(bool wait, T* out, bool* done) {
+    base::AutoLock auto_lock(lock_);
+    if (!wait && !items_.empty()) {
+      *out = std::move(items_.front());
+      items_.pop_front();
+      not_full_.Signal();
+      return true;
+    }
+    if (!wait && closed_) {
+      *done = true;
+      return false;
+    }
+    ++waiting_;
+    ScheduleDrainLocked();
+    return false;
+  }
+
+  void Attach(AsyncIterator<T>* consumer) {
+    base::AutoLock auto_lock(lock_);
+    consumer_ = consumer;
+  }
+
+  void Cancel() {
+    std::deque<T> items;
+    {
+      base::AutoLock auto_lock(lock_);
+      cancelled_ = true;
+      closed_ = true;
+      consumer_ = NULL;
+      waiting_ = 0;
+      items.swap(items_);
+    }
+    not_full_.Broadcast();
+  }
+
+  // Moves as many values as there are pending next() out of the buffer and
+  // delivers them.
+  void Drain() {
+    std::vector<T> batch;
+    bool finished = false;
+    AsyncIterator<T>* consumer = NULL;
+    {
+      base::AutoLock auto_lock(lock_);
+      drain_scheduled_ = false;
+      size_t count = std::min(waiting_, items_.size());
+      batch.reserve(count);
+      for (size_t i = 0; i < count; ++i) {
+        batch.push_back(std::move(items_.front()));
+        items_.pop_front();
+      }
+      waiting_ -= count;
+      if (closed_ && items_.empty()) {
+        finished = waiting_ > 0;
+        waiting_ = 0;
+      }
+      consumer = consumer_;
+    }
+    if (!batch.empty())
+      not_full_.Broadcast();
+    if (consumer)
+      consumer->Deliver(&batch, finished);
+  }
+
+  const size_t capacity_;
+  base::Lock lock_;
+  base::ConditionVariable not_full_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+
+  // Guarded by |lock_|.
+  std::deque<T> items_;
+  AsyncIterator<T>* consumer_;
+  size_t waiting_;
+  bool closed_;
+  bool cancelled_;
+  bool drain_scheduled_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncProducer);
+};
+
+// The JavaScript async iterator over the values of an AsyncProducer, which
+// are converted with Converter<T>::ToV8. Created on the isolate thread.
+template<typename T>
+class AsyncIterator : public internal::AsyncIteratorBase {
+ public:
+  static v8::Local<v8::Object> Create(
+      v8::Isolate* isolate, const scoped_refptr<AsyncProducer<T> >& producer) {
+    return (new AsyncIterator(producer))->GetWrapper(isolate);
+  }
+
+ protected:
+  PollResult Poll(v8::Isolate* isolate,
+                  bool wait,
+                  v8::Local<v8::Value>* value) override {
+    T item;
+    bool done = false;
+    if (producer_->Poll(wait, &item, &done)) {
+      *value = ConvertToV8(isolate, item);
+      return POLL_VALUE;
+    }
+    return done ? POLL_DONE : POLL_PENDING;
+  }
+
+  void Cancel() override {
+    producer_->Cancel();
+  }
+
+ private:
+  friend class AsyncProducer<T>;
+
+  explicit AsyncIterator(const scoped_refptr<AsyncProducer<T> >& producer)
+      : producer_(producer) {
+    producer_->Attach(this);
+  }
+
+  ~AsyncIterator() override {
+    producer_->Cancel();
+  }
+
+  void Deliver(std::vector<T>* batch, bool finished) {
+    v8::Isolate* isolate = this->isolate();
+    {
+      v8::HandleScope handle_scope(isolate);
+      v8::Local<v8::Context> context =
+          GetWrapper(isolate)->CreationContext();
+      v8::Context::Scope context_scope(context);
+      for (size_t i = 0; i < batch->size(); ++i)
+        ResolveNext(context, ConvertToV8(isolate, (*batch)[i]));
+      if (finished)
+        ResolveAllDone(context);
+    }
+    RunMicrotasks(isolate);
+  }
+
+  scoped_refptr<AsyncProducer<T> > producer_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncIterator);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_ASYNC_ITERATOR_H_
@@ -0,0 +1,169 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/backing_store.h"
+
+#include <utility>
+
+#include "native_mate/array_buffer_allocator.h"
+#include "native_mate/private_key.h"
+
+namespace mate {
+
+namespace {
+
+const PrivateKey kBackingStoreKey("mate::BackingStore");
+
+void DeleteVector(void* data, size_t length, void* deleter_data) {
+  delete static_cast<std::vector<uint8_t>*>(deleter_data);
+}
+
+void FreeToAllocator(void* data, size_t length, void* deleter_data) {
+  static_cast<PooledArrayBufferAllocator*>(deleter_data)->Free(data, length);
+}
+
+// Keeps a reference to the store until the buffer is collected.
+class ExternalBuffer {
+ public:
+  ExternalBuffer(v8::Isolate* isolate,
+                 v8::Local<v8::Object> buffer,
+                 const scoped_refptr<BackingStore>& store)
+      : store_(store), buffer_(isolate, buffer) {
+    buffer_.SetWeak(this, FirstWeakCallback,
+                    v8::WeakCallbackType::kParameter);
+    if (store_->external_memory() > 0)
+      isolate->AdjustAmountOfExternalAllocatedMemory(
+          store_->external_memory());
+  }
+
+ private:
+  static void FirstWeakCallback(
+      const v8::WeakCallbackInfo<ExternalBuffer>& data) {
+    data.GetParameter()->buffer_.Reset();
+    data.SetSecondPassCallback(SecondWeakCallback);
+  }
+
+  static void SecondWeakCallback(
+      const v8::WeakCallbackInfo<ExternalBuffer>& data) {
+    ExternalBuffer* self = data.GetParameter();
+    if (self->store_->external_memory() > 0)
+      data.GetIsolate()->AdjustAmountOfExternalAllocatedMemory(
+          -static_cast<int64_t>(self->store_->external_memory()));
+    delete self;
+  }
+
+  scoped_refptr<BackingStore> store_;
+  v8::UniquePersistent<v8::Object> buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(ExternalBuffer);
+};
+
+}  // namespace
+
+// static
+scoped_refptr<BackingStore> BackingStore::Wrap(void* data,
+                                               size_t length,
+                                               Deleter deleter,
+                                               void* deleter_data) {
+  return new BackingStore(data, length, deleter, deleter_data);
+}
+
+// static
+scoped_refptr<BackingStore> BackingStore::WrapMapped(void* data,
+                                                     size_t length,
+                                                     Deleter deleter,
+                                                     void* deleter_data) {
+  scoped_refptr<BackingStore> store =
+      new BackingStore(data, length, deleter, deleter_data);
+  store->is_mapped_ = true;
+  return store;
+}
+
+// static
+scoped_refptr<BackingStore> BackingStore::Take(std::vector<uint8_t> bytes) {
+  std::vector<uint8_t>* holder = new std::vector<uint8_t>(std::move(bytes));
+  return new BackingStore(holder->empty() ? NULL : &holder->front(),
+                          holder->size(), &DeleteVector, holder);
+}
+
+// static
+scoped_refptr<BackingStore> BackingStore::Allocate(
+    PooledArrayBufferAllocator* allocator, size_t length) {
+  void* data = allocator->AllocateUninitialized(length);
+  if (!data)
+    return NULL;
+  return new BackingStore(data, length, &FreeToAllocator, allocator);
+}
+
+BackingStore::BackingStore(void* data,
+                           size_t length,
+                           Deleter deleter,
+                           void* deleter_data)
+    : data_(data),
+      length_(length),
+      deleter_(deleter),
+      deleter_data_(deleter_data),
+      is_mapped_(false) {
+}
+
+BackingStore::~BackingStore() {
+  if (deleter_)
+    deleter_(data_, length_, deleter_data_);
+}
+
+namespace internal {
+
+bool AttachBackingStore(v8::Isolate* isolate,
+                        v8::Local<v8::Object> buffer,
+                        const scoped_refptr<BackingStore>& store) {
+  v8::Local<v8::Private> key = kBackingStoreKey.Get(isolate);
+  if (!buffer->SetPrivate(isolate->GetCurrentContext(), key,
+                          MATE_EXTERNAL_NEW(isolate, store.get()))
+           .FromMaybe(false))
+    return false;
+  new ExternalBuffer(isolate, buffer, store);
+  return true;
+}
+
+scoped_refptr<BackingStore> GetAttachedBackingStore(
+    v8::Isolate* isolate, v8::Local<v8::Object> buffer) {
+  v8::Local<v8::Private> key = kBackingStoreKey.Get(isolate);
+  v8::Local<v8::Value> store;
+  if (!buffer->GetPrivate(isolate->GetCurrentContext(), key).ToLocal(&store) ||
+      !store->IsExternal())
+    return NULL;
+  return static_cast<BackingStore*>(
+      v8::Local<v8::External>::Cast(store)->Value());
+}
+
+}  // namespace internal
+
+v8::Local<v8::Value> Converter<scoped_refptr<BackingStore> >::ToV8(
+    v8::Isolate* isolate, const scoped_refptr<BackingStore>& val) {
+  if (!val)
+    return v8::Null(isolate);
+
+  v8::Local<v8::ArrayBuffer> buffer = v8::ArrayBuffer::New(
+      isolate, val->data(), val->length(),
+      v8::ArrayBufferCreationMode::kExternalized);
+  if (!internal::AttachBackingStore(isolate, buffer, val))
+    return v8::Local<v8::Value>();
+  return buffer;
+}
+
+bool Converter<scoped_refptr<BackingStore> >::FromV8(
+    v8::Isolate* isolate,
+    v8::Local<v8::Value> val,
+    scoped_refptr<BackingStore>* out) {
+  if (!val->IsArrayBuffer())
+    return false;
+  scoped_refptr<BackingStore> store = internal::GetAttachedBackingStore(
+      isolate, v8::Local<v8::Object>::Cast(val));
+  if (!store)
+    return false;
+  *out = store;
+  return true;
+}
+
+}  // namespace mate
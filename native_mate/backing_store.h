@@ -0,0 +1,156 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_BACKING_STORE_H_
+#define NATIVE_MATE_BACKING_STORE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "native_mate/converter.h"
+#include "native_mate/typed_array_traits.h"
+
+namespace mate {
+
+class PooledArrayBufferAllocator;
+
+// BackingStore is a block of native memory that can be handed to JavaScript
+// as an ArrayBuffer without copying. The memory is released by |deleter|
+// when the last reference is dropped, either by native code or by the
+// garbage collector once no ArrayBuffer uses it.
+//
+//   std::vector<uint8_t> bytes = ReadFrame();
+//   return mate::ConvertToV8(isolate,
+//                            mate::BackingStore::Take(std::move(bytes)));
+//
+// The converter creates a new ArrayBuffer each time, several ArrayBuffers can
+// share one BackingStore.
+class BackingStore : public base::RefCountedThreadSafe<BackingStore> {
+ public:
+  typedef void (*Deleter)(void* data, size_t length, void* deleter_data);
+
+  // Wraps |data|, which is released with |deleter|.
+  static scoped_refptr<BackingStore> Wrap(void* data,
+                                          size_t length,
+                                          Deleter deleter,
+                                          void* deleter_data);
+
+  // Like Wrap, for memory that is not allocated, like a mapped file. Its
+  // pages are loaded and dropped by the system, so it is not reported to the
+  // garbage collector as external memory.
+  static scoped_refptr<BackingStore> WrapMapped(void* data,
+                                                size_t length,
+                                                Deleter deleter,
+                                                void* deleter_data);
+
+  // Takes the contents of |bytes| without copying them.
+  static scoped_refptr<BackingStore> Take(std::vector<uint8_t> bytes);
+
+  // Allocates |length| uninitialized bytes from |allocator|, the memory goes
+  // back to its pool when the store is released. Returns NULL on failure.
+  static scoped_refptr<BackingStore> Allocate(
+      PooledArrayBufferAllocator* allocator, size_t length);
+
+  void* data() const { return data_; }
+  size_t length() const { return length_; }
+
+  // The number of bytes the buffers over the store report to the garbage
+  // collector.
+  size_t external_memory() const { return is_mapped_ ? 0 : length_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<BackingStore>;
+
+  BackingStore(void* data, size_t length, Deleter deleter, void* deleter_data);
+  ~BackingStore();
+
+  void* data_;
+  size_t length_;
+  Deleter deleter_;
+  void* deleter_data_;
+  bool is_mapped_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackingStore);
+};
+
+// A typed array over a range of a BackingStore. |offset| is in bytes and
+// |length| in elements.
+template<typename T>
+struct BackingStoreView {
+  static_assert(TypedArrayTraits<T>::kIsSupported,
+                "BackingStoreView needs a typed array element type");
+
+  BackingStoreView() : offset(0), length(0) {}
+  BackingStoreView(scoped_refptr<BackingStore> store,
+                   size_t offset,
+                   size_t length)
+      : store(store), offset(offset), length(length) {}
+
+  T* data() const {
+    return reinterpret_cast<T*>(static_cast<char*>(store->data()) + offset);
+  }
+
+  scoped_refptr<BackingStore> store;
+  size_t offset;
+  size_t length;
+};
+
+namespace internal {
+
+// Makes the externalized |buffer|, an ArrayBuffer or a SharedArrayBuffer
+// over |store|'s memory, keep |store| alive until it is collected.
+bool AttachBackingStore(v8::Isolate* isolate,
+                        v8::Local<v8::Object> buffer,
+                        const scoped_refptr<BackingStore>& store);
+
+// Returns the store attached to |buffer|, or NULL.
+scoped_refptr<BackingStore> GetAttachedBackingStore(
+    v8::Isolate* isolate, v8::Local<v8::Object> buffer);
+
+}  // namespace internal
+
+// ToV8 creates an externalized ArrayBuffer that keeps the store alive and
+// reports its external_memory() to the garbage collector. FromV8 only accepts
+// ArrayBuffers created this way.
+template<>
+struct Converter<scoped_refptr<BackingStore> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const scoped_refptr<BackingStore>& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     scoped_refptr<BackingStore>* out);
+};
+
+template<typename T>
+struct Converter<BackingStoreView<T> > {
+  typedef typename TypedArrayTraits<T>::ArrayType ArrayType;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const BackingStoreView<T>& val) {
+    v8::Local<v8::Value> buffer = ConvertToV8(isolate, val.store);
+    if (buffer.IsEmpty() || !buffer->IsArrayBuffer())
+      return buffer;
+    return ArrayType::New(v8::Local<v8::ArrayBuffer>::Cast(buffer),
+                          val.offset, val.length);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     BackingStoreView<T>* out) {
+    if (!TypedArrayTraits<T>::IsTypedArray(val))
+      return false;
+    v8::Local<v8::TypedArray> array = v8::Local<v8::TypedArray>::Cast(val);
+    scoped_refptr<BackingStore> store;
+    if (!ConvertFromV8(isolate, array->Buffer(), &store))
+      return false;
+    *out = BackingStoreView<T>(store, array->ByteOffset(), array->Length());
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_BACKING_STORE_H_
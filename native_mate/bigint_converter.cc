@@ -0,0 +1,147 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/bigint_converter.h"
+
+#if MATE_V8_AT_LEAST(6, 8)
+
+#include <math.h>
+#include <string.h>
+
+#include <iterator>
+
+#include "native_mate/typed_array_traits.h"
+
+namespace mate {
+
+namespace {
+
+// Largest integer a double holds exactly along with all the smaller ones.
+const double kMaxSafeInteger = 9007199254740991.0;
+
+// Reads an integral Number that converts exactly, into |out|.
+bool GetSafeInteger(v8::Local<v8::Value> val, double* out) {
+  if (!val->IsNumber())
+    return false;
+  double value = v8::Local<v8::Number>::Cast(val)->Value();
+  if (floor(value) != value || fabs(value) > kMaxSafeInteger)
+    return false;
+  *out = value;
+  return true;
+}
+
+// Copies |val| into a new typed array of type ArrayType.
+template<typename ArrayType, typename T>
+v8::Local<v8::Value> ToTypedArray(v8::Isolate* isolate,
+                                  const std::vector<T>& val) {
+  size_t byte_length = val.size() * sizeof(T);
+  v8::Local<v8::ArrayBuffer> buffer =
+      v8::ArrayBuffer::New(isolate, byte_length);
+  if (byte_length > 0)
+    memcpy(buffer->GetContents().Data(), val.data(), byte_length);
+  return ArrayType::New(buffer, 0, val.size());
+}
+
+// Copies |val| into |out| when |is_typed_array| tells it is a typed array
+// of T, or converts it when it is an array.
+template<typename T>
+bool FromTypedArray(v8::Isolate* isolate,
+                    v8::Local<v8::Value> val,
+                    bool is_typed_array,
+                    std::vector<T>* out) {
+  std::vector<T> result;
+  if (is_typed_array) {
+    v8::Local<v8::TypedArray> array = v8::Local<v8::TypedArray>::Cast(val);
+    result.resize(array->Length());
+    if (!result.empty())
+      memcpy(&result[0], GetTypedArrayData<T>(array),
+             result.size() * sizeof(T));
+  } else if (val->IsArray()) {
+    v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(val);
+    result.reserve(internal::GetArrayReserveSize(array->Length()));
+    if (!internal::ElementsFromV8<T>(isolate, array,
+                                     std::back_inserter(result)))
+      return false;
+  } else {
+    return false;
+  }
+  out->swap(result);
+  return true;
+}
+
+}  // namespace
+
+v8::Local<v8::Value> Converter<ExactInt64>::ToV8(v8::Isolate* isolate,
+                                                 ExactInt64 val) {
+  return v8::BigInt::New(isolate, val.value);
+}
+
+bool Converter<ExactInt64>::FromV8(v8::Isolate* isolate,
+                                   v8::Local<v8::Value> val,
+                                   ExactInt64* out) {
+  if (val->IsBigInt()) {
+    bool lossless = false;
+    int64_t value = v8::Local<v8::BigInt>::Cast(val)->Int64Value(&lossless);
+    if (!lossless)
+      return false;
+    out->value = value;
+    return true;
+  }
+  double value;
+  if (!GetSafeInteger(val, &value))
+    return false;
+  out->value = static_cast<int64_t>(value);
+  return true;
+}
+
+v8::Local<v8::Value> Converter<ExactUint64>::ToV8(v8::Isolate* isolate,
+                                                  ExactUint64 val) {
+  return v8::BigInt::NewFromUnsigned(isolate, val.value);
+}
+
+bool Converter<ExactUint64>::FromV8(v8::Isolate* isolate,
+                                    v8::Local<v8::Value> val,
+                                    ExactUint64* out) {
+  if (val->IsBigInt()) {
+    bool lossless = false;
+    uint64_t value = v8::Local<v8::BigInt>::Cast(val)->Uint64Value(&lossless);
+    if (!lossless)
+      return false;
+    out->value = value;
+    return true;
+  }
+  double value;
+  if (!GetSafeInteger(val, &value) || value < 0)
+    return false;
+  out->value = static_cast<uint64_t>(value);
+  return true;
+}
+
+v8::Local<v8::Value> Converter<std::vector<ExactInt64> >::ToV8(
+    v8::Isolate* isolate, const std::vector<ExactInt64>& val) {
+  return ToTypedArray<v8::BigInt64Array>(isolate, val);
+}
+
+bool Converter<std::vector<ExactInt64> >::FromV8(
+    v8::Isolate* isolate,
+    v8::Local<v8::Value> val,
+    std::vector<ExactInt64>* out) {
+  return FromTypedArray(isolate, val, val->IsBigInt64Array(), out);
+}
+
+v8::Local<v8::Value> Converter<std::vector<ExactUint64> >::ToV8(
+    v8::Isolate* isolate, const std::vector<ExactUint64>& val) {
+  return ToTypedArray<v8::BigUint64Array>(isolate, val);
+}
+
+bool Converter<std::vector<ExactUint64> >::FromV8(
+    v8::Isolate* isolate,
+    v8::Local<v8::Value> val,
+    std::vector<ExactUint64>* out) {
+  return FromTypedArray(isolate, val, val->IsBigUint64Array(), out);
+}
+
+}  // namespace mate
+
+#endif  // MATE_V8_AT_LEAST(6, 8)
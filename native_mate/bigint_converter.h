@@ -0,0 +1,93 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_BIGINT_CONVERTER_H_
+#define NATIVE_MATE_BIGINT_CONVERTER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "native_mate/converter.h"
+
+#if MATE_V8_AT_LEAST(6, 8)
+
+namespace mate {
+
+// Converter<int64_t> and Converter<uint64_t> go through a double, which only
+// holds integers of up to 53 bits exactly. ExactInt64 and ExactUint64 are
+// converted to BigInts instead, so 64-bit IDs keep every bit:
+//
+//   mate::ExactUint64 GetId() { return mate::ExactUint64(id_); }  // 42n
+//
+// FromV8 accepts a BigInt that fits in the type, or a Number that is an
+// integer small enough to be exact. Vectors of them convert to and from a
+// BigInt64Array or BigUint64Array with one copy, and also accept arrays.
+struct ExactInt64 {
+  ExactInt64() : value(0) {}
+  explicit ExactInt64(int64_t value) : value(value) {}
+
+  int64_t value;
+};
+
+struct ExactUint64 {
+  ExactUint64() : value(0) {}
+  explicit ExactUint64(uint64_t value) : value(value) {}
+
+  uint64_t value;
+};
+
+static_assert(sizeof(ExactInt64) == sizeof(int64_t) &&
+                  sizeof(ExactUint64) == sizeof(uint64_t),
+              "Exact integers must have the layout of a typed array element");
+
+template<>
+struct Converter<ExactInt64> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, ExactInt64 val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     ExactInt64* out);
+};
+
+template<>
+struct Converter<ExactUint64> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, ExactUint64 val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     ExactUint64* out);
+};
+
+namespace internal {
+
+template<>
+struct IsElementwiseVector<ExactInt64> : std::false_type {};
+
+template<>
+struct IsElementwiseVector<ExactUint64> : std::false_type {};
+
+}  // namespace internal
+
+template<>
+struct Converter<std::vector<ExactInt64> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::vector<ExactInt64>& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::vector<ExactInt64>* out);
+};
+
+template<>
+struct Converter<std::vector<ExactUint64> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::vector<ExactUint64>& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::vector<ExactUint64>* out);
+};
+
+}  // namespace mate
+
+#endif  // MATE_V8_AT_LEAST(6, 8)
+
+#endif  // NATIVE_MATE_BIGINT_CONVERTER_H_
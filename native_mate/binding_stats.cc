@@ -0,0 +1,232 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/binding_stats.h"
+
+#if MATE_ENABLE_BINDING_STATS
+
+#include <algorithm>
+#include <map>
+
+#include "base/lazy_instance.h"
+#include "base/synchronization/lock.h"
+
+namespace mate {
+
+namespace {
+
+typedef std::map<std::string, BindingStats*> BindingStatsMap;
+typedef std::map<v8::Isolate*, BindingStats*> CurrentStatsMap;
+
+// Guards the maps, which are only used while bindings are created and when
+// the stats are read.
+base::LazyInstance<base::Lock>::Leaky g_lock = LAZY_INSTANCE_INITIALIZER;
+base::LazyInstance<BindingStatsMap>::Leaky g_stats =
+    LAZY_INSTANCE_INITIALIZER;
+base::LazyInstance<CurrentStatsMap>::Leaky g_current =
+    LAZY_INSTANCE_INITIALIZER;
+
+const size_t kSubBuckets = 1 << BindingHistogram::kSubBucketBits;
+
+int Log2Floor(uint64_t value) {
+  int log = 0;
+  for (int shift = 32; shift > 0; shift >>= 1) {
+    if (value >> shift) {
+      value >>= shift;
+      log += shift;
+    }
+  }
+  return log;
+}
+
+// Values below kSubBuckets have a bucket each, larger ones share a bucket
+// with the values that have the same top kSubBucketBits + 1 bits.
+size_t GetBucket(uint64_t value) {
+  if (value < kSubBuckets)
+    return static_cast<size_t>(value);
+  int log = Log2Floor(value);
+  int shift = log - static_cast<int>(BindingHistogram::kSubBucketBits);
+  size_t bucket = (log - BindingHistogram::kSubBucketBits + 1) * kSubBuckets +
+                  static_cast<size_t>((value >> shift) & (kSubBuckets - 1));
+  return std::min(bucket, BindingHistogram::kBucketCount - 1);
+}
+
+// Returns the largest value of |bucket|.
+uint64_t GetBucketLimit(size_t bucket) {
+  if (bucket < kSubBuckets)
+    return bucket;
+  int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+  uint64_t lower = static_cast<uint64_t>(kSubBuckets + bucket % kSubBuckets)
+                   << shift;
+  return lower + (static_cast<uint64_t>(1) << shift) - 1;
+}
+
+uint64_t GetPercentile(const std::vector<uint64_t>& buckets,
+                       uint64_t count,
+                       uint64_t max,
+                       int percent) {
+  uint64_t rank = (count * percent + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    seen += buckets[i];
+    if (seen >= rank && seen > 0)
+      return std::min(GetBucketLimit(i), max);
+  }
+  return max;
+}
+
+}  // namespace
+
+BindingHistogram::BindingHistogram() {
+  Reset();
+}
+
+void BindingHistogram::Record(uint64_t nanoseconds) {
+  buckets_[GetBucket(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+  total_.fetch_add(nanoseconds, std::memory_order_relaxed);
+  uint64_t max = max_.load(std::memory_order_relaxed);
+  while (nanoseconds > max &&
+         !max_.compare_exchange_weak(max, nanoseconds,
+                                     std::memory_order_relaxed)) {
+  }
+}
+
+BindingHistogramSnapshot BindingHistogram::GetSnapshot() const {
+  BindingHistogramSnapshot snapshot;
+  std::vector<uint64_t> buckets(kBucketCount);
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += buckets[i];
+  }
+  snapshot.total = total_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  snapshot.p50 = GetPercentile(buckets, snapshot.count, snapshot.max, 50);
+  snapshot.p90 = GetPercentile(buckets, snapshot.count, snapshot.max, 90);
+  snapshot.p99 = GetPercentile(buckets, snapshot.count, snapshot.max, 99);
+  return snapshot;
+}
+
+void BindingHistogram::Reset() {
+  for (size_t i = 0; i < kBucketCount; ++i)
+    buckets_[i].store(0, std::memory_order_relaxed);
+  total_.store(0, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+}
+
+BindingStats::BindingStats(const std::string& name) : name_(name), failed_(0) {
+}
+
+// static
+BindingStats* BindingStats::Get(const base::StringPiece& name) {
+  base::AutoLock auto_lock(g_lock.Get());
+  BindingStats*& stats = g_stats.Get()[name.as_string()];
+  if (!stats)
+    stats = new BindingStats(name.as_string());
+  return stats;
+}
+
+// static
+std::vector<BindingStatsSnapshot> BindingStats::GetAll() {
+  base::AutoLock auto_lock(g_lock.Get());
+  std::vector<BindingStatsSnapshot> result;
+  result.reserve(g_stats.Get().size());
+  for (BindingStatsMap::const_iterator it = g_stats.Get().begin();
+       it != g_stats.Get().end(); ++it)
+    result.push_back(it->second->GetSnapshot());
+  return result;
+}
+
+// static
+void BindingStats::ResetAll() {
+  base::AutoLock auto_lock(g_lock.Get());
+  for (BindingStatsMap::const_iterator it = g_stats.Get().begin();
+       it != g_stats.Get().end(); ++it)
+    it->second->Reset();
+}
+
+void BindingStats::RecordFailedCall() {
+  failed_.fetch_add(1, std::memory_order_relaxed);
+}
+
+BindingStatsSnapshot BindingStats::GetSnapshot() const {
+  BindingStatsSnapshot snapshot;
+  snapshot.name = name_;
+  snapshot.arguments = arguments_.GetSnapshot();
+  snapshot.callback = callback_.GetSnapshot();
+  snapshot.result = result_.GetSnapshot();
+  snapshot.calls = snapshot.arguments.count;
+  snapshot.failed = failed_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+void BindingStats::Reset() {
+  arguments_.Reset();
+  callback_.Reset();
+  result_.Reset();
+  failed_.store(0, std::memory_order_relaxed);
+}
+
+namespace internal {
+
+BindingStats* GetCurrentBindingStats(v8::Isolate* isolate) {
+  base::AutoLock auto_lock(g_lock.Get());
+  CurrentStatsMap::const_iterator it = g_current.Get().find(isolate);
+  return it == g_current.Get().end() ? NULL : it->second;
+}
+
+BindingStatsScope::BindingStatsScope(v8::Isolate* isolate,
+                                     const base::StringPiece& prefix,
+                                     const base::StringPiece& name)
+    : isolate_(isolate), previous_(GetCurrentBindingStats(isolate)) {
+  BindingStats* stats = BindingStats::Get(prefix.as_string() +
+                                          name.as_string());
+  base::AutoLock auto_lock(g_lock.Get());
+  g_current.Get()[isolate_] = stats;
+}
+
+BindingStatsScope::~BindingStatsScope() {
+  base::AutoLock auto_lock(g_lock.Get());
+  if (previous_)
+    g_current.Get()[isolate_] = previous_;
+  else
+    g_current.Get().erase(isolate_);
+}
+
+BindingCallTimer::BindingCallTimer(BindingStats* stats)
+    : stats_(stats), phase_(0) {
+  if (stats_)
+    start_ = Clock::now();
+}
+
+BindingCallTimer::~BindingCallTimer() {
+  // The result is only converted when the callback ran.
+  if (phase_ == 2)
+    Mark();
+}
+
+void BindingCallTimer::Mark() {
+  if (!stats_)
+    return;
+  Clock::time_point now = Clock::now();
+  uint64_t nanoseconds = static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_)
+          .count());
+  BindingHistogram* phases[] = {
+    stats_->arguments(), stats_->callback(), stats_->result(),
+  };
+  if (phase_ < 3)
+    phases[phase_++]->Record(nanoseconds);
+  start_ = now;
+}
+
+void BindingCallTimer::Fail() {
+  if (stats_)
+    stats_->RecordFailedCall();
+}
+
+}  // namespace internal
+
+}  // namespace mate
+
+#endif  // MATE_ENABLE_BINDING_STATS
@@ -0,0 +1,201 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_BINDING_STATS_H_
+#define NATIVE_MATE_BINDING_STATS_H_
+
+// Whether the methods and properties set with ObjectTemplateBuilder record
+// their calls in BindingStats. Without it none of this is compiled and the
+// dispatch of calls is unchanged.
+#ifndef MATE_ENABLE_BINDING_STATS
+#define MATE_ENABLE_BINDING_STATS 0
+#endif
+
+#if MATE_ENABLE_BINDING_STATS
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/strings/string_piece.h"
+#include "native_mate/converter.h"
+#include "native_mate/struct_converter.h"
+
+namespace mate {
+
+// The distribution of the durations of one phase of a binding's calls, in
+// nanoseconds. Percentiles are the upper bound of their bucket.
+struct BindingHistogramSnapshot {
+  BindingHistogramSnapshot()
+      : count(0), total(0), max(0), p50(0), p90(0), p99(0) {}
+
+  uint64_t count;
+  uint64_t total;
+  uint64_t max;
+  uint64_t p50;
+  uint64_t p90;
+  uint64_t p99;
+};
+
+struct BindingStatsSnapshot {
+  BindingStatsSnapshot() : calls(0), failed(0) {}
+
+  std::string name;
+  // Every call, including the failed ones, whose arguments did not convert
+  // and which only have an arguments time.
+  uint64_t calls;
+  uint64_t failed;
+  // Converting the arguments to C++, running the C++ function and
+  // converting its result back.
+  BindingHistogramSnapshot arguments;
+  BindingHistogramSnapshot callback;
+  BindingHistogramSnapshot result;
+};
+
+// BindingHistogram counts durations in log-linear buckets, like an HDR
+// histogram with two significant bits: each power of two is split in four
+// buckets, so a value is off by at most a quarter. Recording is a few
+// relaxed atomic operations, without locks, from any thread.
+class BindingHistogram {
+ public:
+  static const size_t kSubBucketBits = 2;
+  // Values up to 2^40 nanoseconds, about 18 minutes.
+  static const size_t kBucketCount = 160;
+
+  BindingHistogram();
+
+  void Record(uint64_t nanoseconds);
+  BindingHistogramSnapshot GetSnapshot() const;
+  void Reset();
+
+ private:
+  std::atomic<uint64_t> buckets_[kBucketCount];
+  std::atomic<uint64_t> total_;
+  std::atomic<uint64_t> max_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingHistogram);
+};
+
+// BindingStats counts the calls of the bindings with one name, methods by
+// the name given to ObjectTemplateBuilder::SetMethod and properties as
+// "get name" and "set name". The bindings of all isolates share the stats of
+// a name, so isolates on different threads that call the same binding
+// contend on its counters. To find which bindings the native time goes to,
+// build with
+// MATE_ENABLE_BINDING_STATS=1 and dump the stats, from C++ or from
+// JavaScript through the converter of BindingStatsSnapshot:
+//
+//   builder.SetMethod("getBindingStats", &mate::BindingStats::GetAll);
+class BindingStats {
+ public:
+  // Returns the stats of |name|, they are created on first use and live
+  // until the process exits.
+  static BindingStats* Get(const base::StringPiece& name);
+
+  // Returns the stats of every binding, sorted by name.
+  static std::vector<BindingStatsSnapshot> GetAll();
+  static void ResetAll();
+
+  const std::string& name() const { return name_; }
+
+  BindingHistogram* arguments() { return &arguments_; }
+  BindingHistogram* callback() { return &callback_; }
+  BindingHistogram* result() { return &result_; }
+
+  // Counts a call whose arguments did not convert.
+  void RecordFailedCall();
+
+  BindingStatsSnapshot GetSnapshot() const;
+  void Reset();
+
+ private:
+  explicit BindingStats(const std::string& name);
+
+  std::string name_;
+  BindingHistogram arguments_;
+  BindingHistogram callback_;
+  BindingHistogram result_;
+  std::atomic<uint64_t> failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingStats);
+};
+
+namespace internal {
+
+// Returns the stats the CallbackHolders created now in |isolate| record to,
+// NULL outside of a BindingStatsScope.
+BindingStats* GetCurrentBindingStats(v8::Isolate* isolate);
+
+// Makes the bindings created in |isolate| during its lifetime record to the
+// stats of |prefix| followed by |name|.
+class BindingStatsScope {
+ public:
+  BindingStatsScope(v8::Isolate* isolate,
+                    const base::StringPiece& prefix,
+                    const base::StringPiece& name);
+  ~BindingStatsScope();
+
+ private:
+  v8::Isolate* isolate_;
+  BindingStats* previous_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingStatsScope);
+};
+
+// Times the phases of one call of a binding, the phases end with Mark and the
+// last one when the timer is destroyed. Does nothing when |stats| is NULL.
+class BindingCallTimer {
+ public:
+  explicit BindingCallTimer(BindingStats* stats);
+  ~BindingCallTimer();
+
+  void Mark();
+
+  // Ends the call after the arguments failed to convert.
+  void Fail();
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  BindingStats* stats_;
+  Clock::time_point start_;
+  int phase_;
+
+  DISALLOW_COPY_AND_ASSIGN(BindingCallTimer);
+};
+
+}  // namespace internal
+
+}  // namespace mate
+
+MATE_STRUCT(mate::BindingHistogramSnapshot,
+            MATE_FIELD(count, "count"),
+            MATE_FIELD(total, "total"),
+            MATE_FIELD(max, "max"),
+            MATE_FIELD(p50, "p50"),
+            MATE_FIELD(p90, "p90"),
+            MATE_FIELD(p99, "p99"))
+
+MATE_STRUCT(mate::BindingStatsSnapshot,
+            MATE_FIELD(name, "name"),
+            MATE_FIELD(calls, "calls"),
+            MATE_FIELD(failed, "failed"),
+            MATE_FIELD(arguments, "arguments"),
+            MATE_FIELD(callback, "callback"),
+            MATE_FIELD(result, "result"))
+
+#define MATE_BINDING_STATS_SCOPE(isolate, prefix, name) \
+    mate::internal::BindingStatsScope binding_stats_scope(isolate, prefix, name)
+
+#else
+
+#define MATE_BINDING_STATS_SCOPE(isolate, prefix, name)
+
+#endif  // MATE_ENABLE_BINDING_STATS
+
+#endif  // NATIVE_MATE_BINDING_STATS_H_
@@ -0,0 +1,92 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_CALLBACK_H_
+#define NATIVE_MATE_CALLBACK_H_
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/callback.h"
+#include "native_mate/converter.h"
+#include "native_mate/scoped_persistent.h"
+
+namespace mate {
+
+namespace internal {
+
+typedef scoped_refptr<RefCountedPersistent<v8::Function> > SafeV8Function;
+
+// Calls the JavaScript function with the C++ arguments converted in a stack
+// array, inside the function's creation context. The trailing empty handle
+// keeps the array valid when there are no arguments.
+template<typename Sig>
+struct V8FunctionInvoker {};
+
+template<typename... ArgTypes>
+struct V8FunctionInvoker<void(ArgTypes...)> {
+  static void Go(v8::Isolate* isolate,
+                 const SafeV8Function& function,
+                 ArgTypes... raw) {
+    v8::HandleScope handle_scope(isolate);
+    v8::Local<v8::Function> holder = function->NewHandle(isolate);
+    v8::Local<v8::Context> context = holder->CreationContext();
+    v8::Context::Scope context_scope(context);
+    v8::Local<v8::Value> argv[] = {
+      ConvertToV8(isolate, raw)..., v8::Local<v8::Value>()
+    };
+    ignore_result(holder->Call(context, MATE_UNDEFINED(isolate),
+                               sizeof...(ArgTypes), argv));
+  }
+};
+
+template<typename ReturnType, typename... ArgTypes>
+struct V8FunctionInvoker<ReturnType(ArgTypes...)> {
+  static ReturnType Go(v8::Isolate* isolate,
+                       const SafeV8Function& function,
+                       ArgTypes... raw) {
+    ReturnType ret = ReturnType();
+    v8::HandleScope handle_scope(isolate);
+    v8::Local<v8::Function> holder = function->NewHandle(isolate);
+    v8::Local<v8::Context> context = holder->CreationContext();
+    v8::Context::Scope context_scope(context);
+    v8::Local<v8::Value> argv[] = {
+      ConvertToV8(isolate, raw)..., v8::Local<v8::Value>()
+    };
+    v8::Local<v8::Value> result;
+    if (holder->Call(context, MATE_UNDEFINED(isolate), sizeof...(ArgTypes),
+                     argv).ToLocal(&result))
+      ConvertFromV8(isolate, result, &ret);
+    return ret;
+  }
+};
+
+}  // namespace internal
+
+// Converts a JavaScript function to a typed base::Callback. The function is
+// kept alive by a ref-counted persistent handle until the last copy of the
+// callback is destroyed. The callback converts its arguments with
+// Converter<T>::ToV8 and its return value with Converter<T>::FromV8, a
+// return value that fails to convert, or a thrown exception, gives a value
+// initialized ReturnType.
+//
+// The callback must only be run and destroyed on the isolate's thread.
+template<typename Sig>
+struct Converter<base::Callback<Sig> > {
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     base::Callback<Sig>* out) {
+    if (!val->IsFunction())
+      return false;
+
+    internal::SafeV8Function function(
+        new RefCountedPersistent<v8::Function>(isolate, val));
+    *out = base::Bind(&internal::V8FunctionInvoker<Sig>::Go, isolate,
+                      function);
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_CALLBACK_H_
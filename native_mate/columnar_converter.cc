@@ -0,0 +1,29 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/columnar_converter.h"
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+const char* const kStringTableNames[] = { "values", "indices" };
+const KeySet kStringTableKeys(kStringTableNames);
+const RecordTemplate kStringTableTemplate(kStringTableKeys);
+
+}  // namespace
+
+const KeySet& GetStringTableKeys() {
+  return kStringTableKeys;
+}
+
+const RecordTemplate& GetStringTableTemplate() {
+  return kStringTableTemplate;
+}
+
+}  // namespace internal
+
+}  // namespace mate
@@ -0,0 +1,312 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_COLUMNAR_CONVERTER_H_
+#define NATIVE_MATE_COLUMNAR_CONVERTER_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+#include "native_mate/struct_converter.h"
+#include "native_mate/template_util.h"
+#include "native_mate/typed_array_traits.h"
+
+namespace mate {
+
+// Columnar holds records of a MATE_STRUCT type and converts them in the
+// struct-of-arrays form, which costs a few objects instead of one object per
+// record for large result sets. The JavaScript object has a property for each
+// field of the struct:
+//
+//   * Fields that have a TypedArrayTraits become a typed array.
+//   * std::string fields become a string table { values, indices }, where
+//     |values| holds each distinct string once and |indices| is a
+//     Uint32Array of indices into |values|.
+//   * Other fields become an array of converted values.
+//
+// FromV8 accepts the same form, and plain arrays in place of typed arrays.
+// All the columns must have the same length.
+template<typename T>
+struct Columnar {
+  Columnar() {}
+  explicit Columnar(std::vector<T> rows) : rows(std::move(rows)) {}
+
+  std::vector<T> rows;
+};
+
+namespace internal {
+
+// Keys of the string table object.
+const KeySet& GetStringTableKeys();
+const RecordTemplate& GetStringTableTemplate();
+
+// Returns row |i| of |rows|, appending it first when the columns walked so far
+// have not reached it. Lengths of plain array columns can be set from
+// JavaScript without any elements behind them, so |rows| grows as the elements
+// are converted rather than being sized from the length up front.
+template<typename T>
+T& GetRow(std::vector<T>* rows, size_t i) {
+  if (i == rows->size())
+    rows->push_back(T());
+  return (*rows)[i];
+}
+
+// Column of an arbitrary type, stored as a plain array.
+template<typename T, typename M>
+struct ArrayColumn {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::vector<T>& rows,
+                                    M T::* member) {
+    v8::Local<v8::Array> result(
+        MATE_ARRAY_NEW(isolate, static_cast<int>(rows.size())));
+    for (size_t i = 0; i < rows.size(); ++i)
+      result->Set(static_cast<int>(i), ConvertToV8(isolate, rows[i].*member));
+    return result;
+  }
+
+  static bool GetLength(v8::Isolate* isolate,
+                        v8::Local<v8::Value> val,
+                        size_t* length) {
+    if (!val->IsArray())
+      return false;
+    *length = v8::Local<v8::Array>::Cast(val)->Length();
+    return true;
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     M T::* member,
+                     size_t length,
+                     std::vector<T>* rows) {
+    v8::Local<v8::Array> array(v8::Local<v8::Array>::Cast(val));
+    for (size_t i = 0; i < length; ++i) {
+      if (!ConvertFromV8(isolate, array->Get(static_cast<uint32_t>(i)),
+                         &(GetRow(rows, i).*member)))
+        return false;
+    }
+    return true;
+  }
+};
+
+template<typename T, typename M, typename Enable = void>
+struct ColumnTraits : public ArrayColumn<T, M> {};
+
+// Arithmetic column, stored as a typed array.
+template<typename T, typename M>
+struct ColumnTraits<T, M, typename enable_if<
+                              TypedArrayTraits<M>::kIsSupported>::type> {
+  typedef typename TypedArrayTraits<M>::ArrayType ArrayType;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::vector<T>& rows,
+                                    M T::* member) {
+    v8::Local<v8::ArrayBuffer> buffer =
+        v8::ArrayBuffer::New(isolate, rows.size() * sizeof(M));
+    M* data = static_cast<M*>(buffer->GetContents().Data());
+    for (size_t i = 0; i < rows.size(); ++i)
+      data[i] = rows[i].*member;
+    return ArrayType::New(buffer, 0, rows.size());
+  }
+
+  static bool GetLength(v8::Isolate* isolate,
+                        v8::Local<v8::Value> val,
+                        size_t* length) {
+    if (TypedArrayTraits<M>::IsTypedArray(val)) {
+      *length = v8::Local<v8::TypedArray>::Cast(val)->Length();
+      return true;
+    }
+    return ArrayColumn<T, M>::GetLength(isolate, val, length);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     M T::* member,
+                     size_t length,
+                     std::vector<T>* rows) {
+    if (!TypedArrayTraits<M>::IsTypedArray(val))
+      return ArrayColumn<T, M>::FromV8(isolate, val, member, length, rows);
+    const M* data = GetTypedArrayData<M>(
+        v8::Local<v8::ArrayBufferView>::Cast(val));
+    for (size_t i = 0; i < length; ++i)
+      GetRow(rows, i).*member = data[i];
+    return true;
+  }
+};
+
+// String column, stored as a string table.
+template<typename T>
+struct ColumnTraits<T, std::string> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::vector<T>& rows,
+                                    std::string T::* member) {
+    std::map<base::StringPiece, uint32_t> positions;
+    std::vector<base::StringPiece> values;
+    v8::Local<v8::ArrayBuffer> buffer =
+        v8::ArrayBuffer::New(isolate, rows.size() * sizeof(uint32_t));
+    uint32_t* indices = static_cast<uint32_t*>(buffer->GetContents().Data());
+    for (size_t i = 0; i < rows.size(); ++i) {
+      base::StringPiece value(rows[i].*member);
+      std::pair<std::map<base::StringPiece, uint32_t>::iterator, bool> it =
+          positions.insert(
+              std::make_pair(value, static_cast<uint32_t>(values.size())));
+      if (it.second)
+        values.push_back(value);
+      indices[i] = it.first->second;
+    }
+
+    v8::Local<v8::Value> table[] = {
+      ConvertToV8(isolate, values),
+      v8::Uint32Array::New(buffer, 0, rows.size()),
+    };
+    return GetStringTableTemplate().NewWithValues(isolate, table);
+  }
+
+  static bool GetLength(v8::Isolate* isolate,
+                        v8::Local<v8::Value> val,
+                        size_t* length) {
+    if (!val->IsObject() || val->IsArray())
+      return ArrayColumn<T, std::string>::GetLength(isolate, val, length);
+    v8::Local<v8::Value> indices = v8::Local<v8::Object>::Cast(val)->Get(
+        GetStringTableKeys().Get(isolate, 1));
+    if (!indices->IsUint32Array())
+      return false;
+    *length = v8::Local<v8::Uint32Array>::Cast(indices)->Length();
+    return true;
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::string T::* member,
+                     size_t length,
+                     std::vector<T>* rows) {
+    if (val->IsArray())
+      return ArrayColumn<T, std::string>::FromV8(isolate, val, member, length,
+                                                 rows);
+    const KeySet& keys = GetStringTableKeys();
+    v8::Local<v8::Object> table = v8::Local<v8::Object>::Cast(val);
+    std::vector<std::string> values;
+    if (!ConvertFromV8(isolate, table->Get(keys.Get(isolate, 0)), &values))
+      return false;
+    v8::Local<v8::Value> indices_value = table->Get(keys.Get(isolate, 1));
+    if (!indices_value->IsUint32Array() ||
+        v8::Local<v8::Uint32Array>::Cast(indices_value)->Length() != length)
+      return false;
+    const uint32_t* indices = GetTypedArrayData<uint32_t>(
+        v8::Local<v8::ArrayBufferView>::Cast(indices_value));
+    for (size_t i = 0; i < length; ++i) {
+      if (indices[i] >= values.size())
+        return false;
+      GetRow(rows, i).*member = values[indices[i]];
+    }
+    return true;
+  }
+};
+
+// Walks the fields of a MATE_STRUCT type and converts one column per field.
+template<typename T, size_t I, size_t N>
+struct ColumnsWalker {
+  typedef typename StructTraits<T>::Fields Fields;
+  typedef typename std::tuple_element<I, Fields>::type Field;
+  typedef ColumnTraits<T, typename Field::MemberType> Column;
+
+  static void ToV8(v8::Isolate* isolate,
+                   const Fields& fields,
+                   const std::vector<T>& rows,
+                   v8::Local<v8::Value>* columns) {
+    columns[I] = Column::ToV8(isolate, rows, std::get<I>(fields).member);
+    ColumnsWalker<T, I + 1, N>::ToV8(isolate, fields, rows, columns);
+  }
+
+  static bool GetLength(v8::Isolate* isolate,
+                        const v8::Local<v8::Value>* columns,
+                        size_t* length) {
+    size_t column_length;
+    if (!Column::GetLength(isolate, columns[I], &column_length))
+      return false;
+    if (I > 0 && column_length != *length)
+      return false;
+    *length = column_length;
+    return ColumnsWalker<T, I + 1, N>::GetLength(isolate, columns, length);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     const Fields& fields,
+                     const v8::Local<v8::Value>* columns,
+                     size_t length,
+                     std::vector<T>* rows) {
+    if (!Column::FromV8(isolate, columns[I], std::get<I>(fields).member,
+                        length, rows))
+      return false;
+    return ColumnsWalker<T, I + 1, N>::FromV8(isolate, fields, columns, length,
+                                              rows);
+  }
+};
+
+template<typename T, size_t N>
+struct ColumnsWalker<T, N, N> {
+  typedef typename StructTraits<T>::Fields Fields;
+
+  static void ToV8(v8::Isolate* isolate,
+                   const Fields& fields,
+                   const std::vector<T>& rows,
+                   v8::Local<v8::Value>* columns) {}
+  static bool GetLength(v8::Isolate* isolate,
+                        const v8::Local<v8::Value>* columns,
+                        size_t* length) {
+    return true;
+  }
+  static bool FromV8(v8::Isolate* isolate,
+                     const Fields& fields,
+                     const v8::Local<v8::Value>* columns,
+                     size_t length,
+                     std::vector<T>* rows) {
+    return true;
+  }
+};
+
+}  // namespace internal
+
+template<typename T>
+struct Converter<Columnar<T> > {
+  typedef internal::StructConverter<T> Struct;
+  typedef internal::ColumnsWalker<T, 0, Struct::kFieldCount> Walker;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const Columnar<T>& val) {
+    v8::Local<v8::Value> columns[Struct::kFieldCount];
+    Walker::ToV8(isolate, StructTraits<T>::GetFields(), val.rows, columns);
+    return Struct::GetRecordTemplate().NewWithValues(isolate, columns);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     Columnar<T>* out) {
+    if (!val->IsObject())
+      return false;
+    v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(val);
+    const PerIsolateData::KeyList& keys =
+        Struct::GetRecordTemplate().keys().GetKeyList(isolate);
+    v8::Local<v8::Value> columns[Struct::kFieldCount];
+    for (size_t i = 0; i < Struct::kFieldCount; ++i)
+      columns[i] = object->Get(keys[i].Get(isolate));
+
+    size_t length = 0;
+    if (!Walker::GetLength(isolate, columns, &length))
+      return false;
+    std::vector<T> rows;
+    rows.reserve(internal::GetArrayReserveSize(length));
+    if (!Walker::FromV8(isolate, StructTraits<T>::GetFields(), columns, length,
+                        &rows))
+      return false;
+    out->rows.swap(rows);
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_COLUMNAR_CONVERTER_H_
@@ -25,6 +25,9 @@
     v8::String::NewFromUtf8(isolate, data, v8::String::kNormalString, length)
 #define MATE_STRING_NEW_FROM_UTF16(isolate, data, length) \
     v8::String::NewFromTwoByte(isolate, data, v8::String::kNormalString, length)
+#define MATE_STRING_NEW_FROM_ONE_BYTE(isolate, data, length) \
+    v8::String::NewFromOneByte(isolate, data, v8::NewStringType::kNormal, \
+                               length).FromMaybe(v8::Local<v8::String>())
 #define MATE_STRING_NEW_SYMBOL(isolate, data, length) \
     v8::String::NewFromUtf8(isolate, data, v8::String::kInternalizedString, length)
 
@@ -83,6 +86,8 @@
     v8::String::New(data, length)
 #define MATE_STRING_NEW_FROM_UTF16(isolate, data, length) \
     v8::String::NewFromTwoByte(data, v8::String::kNormalString, length)
+#define MATE_STRING_NEW_FROM_ONE_BYTE(isolate, data, length) \
+    v8::String::New(reinterpret_cast<const char*>(data), length)
 #define MATE_STRING_NEW_SYMBOL(isolate, data, length) \
     v8::String::NewSymbol(data, length)
 
@@ -126,6 +131,20 @@
 #endif  // (NODE_MODULE_VERSION > 0x000B)
 
 
+// Whether the V8 in use is at least |major|.|minor|, v8.h must be included
+// before it is used.
+#define MATE_V8_AT_LEAST(major, minor) \
+    (V8_MAJOR_VERSION > (major) || \
+     (V8_MAJOR_VERSION == (major) && V8_MINOR_VERSION >= (minor)))
+
+// Whether the C++17 library types, such as std::optional and std::variant,
+// are available.
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+#define MATE_HAS_CXX17 1
+#else
+#define MATE_HAS_CXX17 0
+#endif
+
 // Generally we should not provide utility macros, but this just makes things
 // much more comfortable so we keep it.
 #define MATE_METHOD(name) \
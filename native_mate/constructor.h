@@ -138,7 +138,7 @@ class Constructor {
     if (constructor_.IsEmpty()) {
       v8::Local<v8::FunctionTemplate> constructor = CreateFunctionTemplate(
           isolate, base::Bind(&Constructor::New, factory));
-      constructor->InstanceTemplate()->SetInternalFieldCount(1);
+      internal::SetUpWrapperTemplate(isolate, constructor->InstanceTemplate());
       constructor->SetClassName(StringToV8(isolate, name_));
       MATE_PERSISTENT_ASSIGN(v8::FunctionTemplate, isolate, constructor_,
                              constructor);
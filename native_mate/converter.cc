@@ -4,11 +4,14 @@
 
 #include "native_mate/converter.h"
 
+#include "native_mate/ascii_util.h"
 #include "native_mate/compat.h"
+#include "native_mate/string_cache.h"
 #include "v8/include/v8.h"
 
 using v8::Array;
 using v8::ArrayBuffer;
+using v8::SharedArrayBuffer;
 using v8::Uint8Array;
 using v8::Uint8ClampedArray;
 using v8::Int8Array;
@@ -57,6 +60,66 @@ bool Converter<unsigned long>::FromV8(Isolate* isolate, Local<Value> val,
 }
 #endif
 
+Local<Value> Converter<int8_t>::ToV8(Isolate* isolate, int8_t val) {
+  return MATE_INTEGER_NEW(isolate, val);
+}
+
+bool Converter<int8_t>::FromV8(Isolate* isolate, Local<Value> val,
+                               int8_t* out) {
+  if (!val->IsInt32())
+    return false;
+  int32_t value = val->Int32Value();
+  if (value < -128 || value > 127)
+    return false;
+  *out = static_cast<int8_t>(value);
+  return true;
+}
+
+Local<Value> Converter<uint8_t>::ToV8(Isolate* isolate, uint8_t val) {
+  return MATE_INTEGER_NEW_UNSIGNED(isolate, val);
+}
+
+bool Converter<uint8_t>::FromV8(Isolate* isolate, Local<Value> val,
+                                uint8_t* out) {
+  if (!val->IsUint32())
+    return false;
+  uint32_t value = val->Uint32Value();
+  if (value > 255)
+    return false;
+  *out = static_cast<uint8_t>(value);
+  return true;
+}
+
+Local<Value> Converter<int16_t>::ToV8(Isolate* isolate, int16_t val) {
+  return MATE_INTEGER_NEW(isolate, val);
+}
+
+bool Converter<int16_t>::FromV8(Isolate* isolate, Local<Value> val,
+                                int16_t* out) {
+  if (!val->IsInt32())
+    return false;
+  int32_t value = val->Int32Value();
+  if (value < -32768 || value > 32767)
+    return false;
+  *out = static_cast<int16_t>(value);
+  return true;
+}
+
+Local<Value> Converter<uint16_t>::ToV8(Isolate* isolate, uint16_t val) {
+  return MATE_INTEGER_NEW_UNSIGNED(isolate, val);
+}
+
+bool Converter<uint16_t>::FromV8(Isolate* isolate, Local<Value> val,
+                                 uint16_t* out) {
+  if (!val->IsUint32())
+    return false;
+  uint32_t value = val->Uint32Value();
+  if (value > 65535)
+    return false;
+  *out = static_cast<uint16_t>(value);
+  return true;
+}
+
 Local<Value> Converter<int32_t>::ToV8(Isolate* isolate, int32_t val) {
   return MATE_INTEGER_NEW(isolate, val);
 }
@@ -138,6 +201,13 @@ Local<Value> Converter<const char*>::ToV8(
 
 Local<Value> Converter<base::StringPiece>::ToV8(
     Isolate* isolate, const base::StringPiece& val) {
+  if (val.length() <= StringCache::kMaxLength && StringCache::IsEnabled())
+    return StringCache::From(isolate)->Get(val);
+  // ASCII text is copied into a one-byte string without UTF-8 decoding.
+  if (internal::IsAscii(val.data(), val.length()))
+    return MATE_STRING_NEW_FROM_ONE_BYTE(
+        isolate, reinterpret_cast<const uint8_t*>(val.data()),
+        static_cast<int>(val.length()));
   return MATE_STRING_NEW_FROM_UTF8(isolate, val.data(),
                                    static_cast<uint32_t>(val.length()));
 }
@@ -154,6 +224,13 @@ bool Converter<std::string>::FromV8(Isolate* isolate, Local<Value> val,
   Local<String> str = Local<String>::Cast(val);
   int length = str->Utf8Length();
   out->resize(length);
+  // One UTF-8 byte per character means the string is ASCII, whose bytes are
+  // copied as they are.
+  if (length == str->Length()) {
+    str->WriteOneByte(reinterpret_cast<uint8_t*>(&(*out)[0]), 0, length,
+                      String::NO_NULL_TERMINATION);
+    return true;
+  }
   str->WriteUtf8(&(*out)[0], length, NULL, String::NO_NULL_TERMINATION);
   return true;
 }
@@ -234,6 +311,19 @@ bool Converter<Local<ArrayBuffer> >::FromV8(Isolate* isolate,
   return true;
 }
 
+Local<Value> Converter<Local<SharedArrayBuffer> >::ToV8(
+    Isolate* isolate, Local<SharedArrayBuffer> val) {
+  return val;
+}
+
+bool Converter<Local<SharedArrayBuffer> >::FromV8(
+    Isolate* isolate, v8::Local<Value> val, Local<SharedArrayBuffer>* out) {
+  if (!val->IsSharedArrayBuffer())
+    return false;
+  *out = Local<SharedArrayBuffer>::Cast(val);
+  return true;
+}
+
 Local<Value> Converter<Local<Uint8Array> >::ToV8(Isolate* isolate,
                                             Local<Uint8Array> val) {
   return val;
@@ -371,6 +461,18 @@ bool Converter<Local<Value> >::FromV8(Isolate* isolate, Local<Value> val,
   return true;
 }
 
+namespace internal {
+
+v8::Local<v8::String> PropertyKeyToV8(v8::Isolate* isolate,
+                                      const base::StringPiece& key) {
+  if (key.length() <= StringCache::kMaxLength)
+    return StringCache::From(isolate)->Get(key);
+  return MATE_STRING_NEW_SYMBOL(isolate, key.data(),
+                                static_cast<uint32_t>(key.length()));
+}
+
+}  // namespace internal
+
 v8::Local<v8::String> StringToSymbol(v8::Isolate* isolate,
                                       const base::StringPiece& val) {
   return MATE_STRING_NEW_SYMBOL(isolate,
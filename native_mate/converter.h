@@ -5,7 +5,13 @@
 #ifndef NATIVE_MATE_CONVERTER_H_
 #define NATIVE_MATE_CONVERTER_H_
 
+#include <iterator>
+#include <map>
 #include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 #include <set>
 
@@ -13,6 +19,13 @@
 #include "native_mate/compat.h"
 #include "v8/include/v8.h"
 
+// Number of elements the container converters convert in one HandleScope.
+// Containers of types that hold handles are converted from V8 in the
+// caller's scope.
+#ifndef MATE_CONVERTER_CHUNK_SIZE
+#define MATE_CONVERTER_CHUNK_SIZE 1024
+#endif
+
 namespace mate {
 
 template<typename T, typename Enable = void>
@@ -45,6 +58,43 @@ struct Converter<unsigned long> {
 };
 #endif
 
+// The narrow integers accept Numbers that are integers in their range.
+template<>
+struct Converter<int8_t> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    int8_t val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     int8_t* out);
+};
+
+template<>
+struct Converter<uint8_t> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    uint8_t val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     uint8_t* out);
+};
+
+template<>
+struct Converter<int16_t> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    int16_t val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     int16_t* out);
+};
+
+template<>
+struct Converter<uint16_t> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    uint16_t val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     uint16_t* out);
+};
+
 template<>
 struct Converter<int32_t> {
   static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
@@ -122,6 +172,34 @@ struct Converter<std::string> {
                      std::string* out);
 };
 
+// UTF-16 strings, such as base::string16 and std::u16string, are copied to
+// and from V8 strings as they are, without going through UTF-8.
+template<typename C, typename Traits, typename Alloc>
+struct Converter<std::basic_string<C, Traits, Alloc>,
+                 typename std::enable_if<sizeof(C) == 2>::type> {
+  typedef std::basic_string<C, Traits, Alloc> String;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, const String& val) {
+    return MATE_STRING_NEW_FROM_UTF16(
+        isolate, reinterpret_cast<const uint16_t*>(val.data()),
+        static_cast<int>(val.size()));
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     String* out) {
+    if (!val->IsString())
+      return false;
+    v8::Local<v8::String> str = v8::Local<v8::String>::Cast(val);
+    int length = str->Length();
+    out->resize(length);
+    if (length > 0)
+      str->Write(reinterpret_cast<uint16_t*>(&(*out)[0]), 0, length,
+                 v8::String::NO_NULL_TERMINATION);
+    return true;
+  }
+};
+
 template<>
 struct Converter<v8::Local<v8::Function> > {
   static bool FromV8(v8::Isolate* isolate,
@@ -174,6 +252,15 @@ struct Converter<v8::Local<v8::ArrayBuffer> > {
                      v8::Local<v8::ArrayBuffer>* out);
 };
 
+template<>
+struct Converter<v8::Local<v8::SharedArrayBuffer> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    v8::Local<v8::SharedArrayBuffer> val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     v8::Local<v8::SharedArrayBuffer>* out);
+};
+
 template<>
 struct Converter<v8::Local<v8::Uint8Array> > {
   static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
@@ -264,15 +351,119 @@ struct Converter<v8::Local<v8::Value> > {
                      v8::Local<v8::Value>* out);
 };
 
+namespace internal {
+
+// Whether std::vector<T> converts with Converter<std::vector<T> > below, to
+// an array of its elements converted one by one. Vectors with a converter of
+// their own specialize it.
+template<typename T>
+struct IsElementwiseVector : std::true_type {};
+
+// Converts the elements in [|begin|, |end|) into |result|. The elements are
+// converted in chunks of MATE_CONVERTER_CHUNK_SIZE, each one in its own
+// HandleScope, so the handles of converted elements do not pile up in the
+// caller's scope.
+template<typename T, typename Iterator>
+void ElementsToV8(v8::Isolate* isolate,
+                  Iterator begin,
+                  Iterator end,
+                  v8::Local<v8::Array> result) {
+  uint32_t index = 0;
+  while (begin != end) {
+    v8::HandleScope handle_scope(isolate);
+    for (size_t i = 0; i < MATE_CONVERTER_CHUNK_SIZE && begin != end;
+         ++i, ++begin, ++index)
+      result->Set(index, Converter<T>::ToV8(isolate, *begin));
+  }
+}
+
+// Whether a T converted from V8 holds no handles, so it stays valid once
+// the HandleScope it was converted in is closed. Types that hold handles,
+// like v8::Local<v8::Value>, Dictionary or Handle<T>, are false.
+template<typename T>
+struct HoldsNoHandles
+    : std::integral_constant<bool, std::is_arithmetic<T>::value ||
+                                       std::is_enum<T>::value> {};
+
+template<typename C, typename Traits, typename Alloc>
+struct HoldsNoHandles<std::basic_string<C, Traits, Alloc> > : std::true_type {};
+
+template<typename T>
+struct HoldsNoHandles<std::vector<T> > : HoldsNoHandles<T> {};
+
+template<typename T>
+struct HoldsNoHandles<std::set<T> > : HoldsNoHandles<T> {};
+
+template<typename T>
+struct HoldsNoHandles<std::unordered_set<T> > : HoldsNoHandles<T> {};
+
+template<typename K, typename V>
+struct HoldsNoHandles<std::map<K, V> >
+    : std::integral_constant<bool, HoldsNoHandles<K>::value &&
+                                       HoldsNoHandles<V>::value> {};
+
+template<typename K, typename V>
+struct HoldsNoHandles<std::unordered_map<K, V> >
+    : std::integral_constant<bool, HoldsNoHandles<K>::value &&
+                                       HoldsNoHandles<V>::value> {};
+
+// The scope a chunk of elements is converted from V8 in: a HandleScope of
+// its own when |kHoldsNoHandles|, the caller's scope otherwise.
+template<bool kHoldsNoHandles>
+class ChunkScope {
+ public:
+  explicit ChunkScope(v8::Isolate* isolate) : handle_scope_(isolate) {}
+
+ private:
+  v8::HandleScope handle_scope_;
+};
+
+template<>
+class ChunkScope<false> {
+ public:
+  explicit ChunkScope(v8::Isolate* isolate) {}
+};
+
+// Returns how many elements to reserve for the conversion of an array of
+// |length|. JavaScript can set the length of an array without any elements
+// behind it, so the reservation is capped and longer results grow as their
+// elements are converted.
+inline size_t GetArrayReserveSize(size_t length) {
+  return length < MATE_CONVERTER_CHUNK_SIZE ? length
+                                            : MATE_CONVERTER_CHUNK_SIZE;
+}
+
+// Converts the elements of |array| and writes them to |out|, in chunks like
+// ElementsToV8 when T holds no handles. Returns false when an element fails
+// to convert.
+template<typename T, typename OutputIterator>
+bool ElementsFromV8(v8::Isolate* isolate,
+                    v8::Local<v8::Array> array,
+                    OutputIterator out) {
+  uint32_t length = array->Length();
+  uint32_t index = 0;
+  while (index < length) {
+    ChunkScope<HoldsNoHandles<T>::value> chunk_scope(isolate);
+    for (size_t i = 0; i < MATE_CONVERTER_CHUNK_SIZE && index < length;
+         ++i, ++index) {
+      T item;
+      if (!Converter<T>::FromV8(isolate, array->Get(index), &item))
+        return false;
+      *out++ = std::move(item);
+    }
+  }
+  return true;
+}
+
+}  // namespace internal
+
 template<typename T>
 struct Converter<std::vector<T> > {
   static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
                                     const std::vector<T>& val) {
     v8::Local<v8::Array> result(
         MATE_ARRAY_NEW(isolate, static_cast<int>(val.size())));
-    for (size_t i = 0; i < val.size(); ++i) {
-      result->Set(static_cast<int>(i), Converter<T>::ToV8(isolate, val[i]));
-    }
+    internal::ElementsToV8<T>(isolate, val.begin(), val.end(), result);
     return result;
   }
 
@@ -284,50 +475,253 @@ struct Converter<std::vector<T> > {
 
     std::vector<T> result;
     v8::Local<v8::Array> array(v8::Local<v8::Array>::Cast(val));
-    uint32_t length = array->Length();
-    for (uint32_t i = 0; i < length; ++i) {
-      T item;
-      if (!Converter<T>::FromV8(isolate, array->Get(i), &item))
-        return false;
-      result.push_back(item);
-    }
+    result.reserve(internal::GetArrayReserveSize(array->Length()));
+    if (!internal::ElementsFromV8<T>(isolate, array,
+                                     std::back_inserter(result)))
+      return false;
 
     out->swap(result);
     return true;
   }
 };
 
+namespace internal {
+
+// Reserves room for |size| elements in the containers that support it.
+template<typename Container>
+void ReserveElements(Container* container, size_t size) {
+}
+
+template<typename K, typename V, typename H, typename E, typename A>
+void ReserveElements(std::unordered_map<K, V, H, E, A>* container,
+                     size_t size) {
+  container->reserve(size);
+}
+
+template<typename T, typename H, typename E, typename A>
+void ReserveElements(std::unordered_set<T, H, E, A>* container, size_t size) {
+  container->reserve(size);
+}
+
+// Converts a set from an array or a Set.
+template<typename Set>
+bool SetFromV8(v8::Isolate* isolate, v8::Local<v8::Value> val, Set* out) {
+  v8::Local<v8::Array> array;
+  size_t reserve;
+  if (val->IsArray()) {
+    array = v8::Local<v8::Array>::Cast(val);
+    reserve = GetArrayReserveSize(array->Length());
+  } else if (val->IsSet()) {
+    // The array of a Set holds every element.
+    array = v8::Local<v8::Set>::Cast(val)->AsArray();
+    reserve = array->Length();
+  } else {
+    return false;
+  }
+
+  Set result;
+  ReserveElements(&result, reserve);
+  if (!ElementsFromV8<typename Set::value_type>(
+          isolate, array, std::inserter(result, result.end())))
+    return false;
+
+  out->swap(result);
+  return true;
+}
+
+// Returns |key| as an internalized string. Short keys come from the
+// StringCache of |isolate|, whether or not it is enabled for the string
+// converters, since the keys of maps tend to repeat from one call to the
+// next.
+v8::Local<v8::String> PropertyKeyToV8(v8::Isolate* isolate,
+                                      const base::StringPiece& key);
+
+// Converts a map with string keys to a plain object. The keys are created as
+// internalized strings, which property keys have to be anyway, so V8 does
+// not copy each key a second time when defining the property.
+template<typename Map>
+v8::Local<v8::Value> MapToV8(v8::Isolate* isolate,
+                             const Map& val,
+                             std::true_type /* string keys */) {
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Object> result = MATE_OBJECT_NEW(isolate);
+  typename Map::const_iterator it = val.begin();
+  while (it != val.end()) {
+    v8::HandleScope handle_scope(isolate);
+    for (size_t i = 0; i < MATE_CONVERTER_CHUNK_SIZE && it != val.end();
+         ++i, ++it) {
+      v8::Local<v8::String> key = PropertyKeyToV8(isolate, it->first);
+      if (!result->CreateDataProperty(
+              context, key,
+              Converter<typename Map::mapped_type>::ToV8(isolate, it->second))
+               .FromMaybe(false))
+        return v8::Local<v8::Value>();
+    }
+  }
+  return result;
+}
+
+// Converts any other map to a Map.
+template<typename Map>
+v8::Local<v8::Value> MapToV8(v8::Isolate* isolate,
+                             const Map& val,
+                             std::false_type /* string keys */) {
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Map> result = v8::Map::New(isolate);
+  typename Map::const_iterator it = val.begin();
+  while (it != val.end()) {
+    v8::HandleScope handle_scope(isolate);
+    for (size_t i = 0; i < MATE_CONVERTER_CHUNK_SIZE && it != val.end();
+         ++i, ++it) {
+      if (result->Set(
+              context,
+              Converter<typename Map::key_type>::ToV8(isolate, it->first),
+              Converter<typename Map::mapped_type>::ToV8(isolate, it->second))
+               .IsEmpty())
+        return v8::Local<v8::Value>();
+    }
+  }
+  return result;
+}
+
+// Converts a map from a Map, or from the own enumerable properties of an
+// object.
+template<typename Map>
+bool MapFromV8(v8::Isolate* isolate, v8::Local<v8::Value> val, Map* out) {
+  typedef typename Map::key_type K;
+  typedef typename Map::mapped_type V;
+  const bool kStringKeys = std::is_same<K, std::string>::value;
+
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Object> object;
+  v8::Local<v8::Array> entries;
+  uint32_t step;
+  if (val->IsMap()) {
+    // AsArray returns the keys and the values interleaved.
+    entries = v8::Local<v8::Map>::Cast(val)->AsArray();
+    step = 2;
+  } else if (val->IsObject()) {
+    object = v8::Local<v8::Object>::Cast(val);
+#if MATE_V8_AT_LEAST(6, 8)
+    // Integer-like keys come back as Numbers unless asked for as strings,
+    // which the maps with string keys need.
+    if (!object->GetOwnPropertyNames(
+                   context,
+                   static_cast<v8::PropertyFilter>(v8::ONLY_ENUMERABLE |
+                                                   v8::SKIP_SYMBOLS),
+                   kStringKeys ? v8::KeyConversionMode::kConvertToString
+                               : v8::KeyConversionMode::kKeepNumbers)
+             .ToLocal(&entries))
+      return false;
+#else
+    if (!object->GetOwnPropertyNames(context).ToLocal(&entries))
+      return false;
+#endif
+    step = 1;
+  } else {
+    return false;
+  }
+
+  Map result;
+  uint32_t length = entries->Length();
+  ReserveElements(&result, length / step);
+  uint32_t index = 0;
+  while (index < length) {
+    ChunkScope<HoldsNoHandles<K>::value && HoldsNoHandles<V>::value>
+        chunk_scope(isolate);
+    for (size_t i = 0; i < MATE_CONVERTER_CHUNK_SIZE && index < length;
+         ++i, index += step) {
+      v8::Local<v8::Value> key;
+      v8::Local<v8::Value> value;
+      if (!entries->Get(context, index).ToLocal(&key))
+        return false;
+      if (object.IsEmpty()) {
+        if (!entries->Get(context, index + 1).ToLocal(&value))
+          return false;
+      } else if (!object->Get(context, key).ToLocal(&value)) {
+        return false;
+      }
+#if !MATE_V8_AT_LEAST(6, 8)
+      if (kStringKeys && !object.IsEmpty() && key->IsNumber() &&
+          !key->ToString(context).ToLocal(&key))
+        return false;
+#endif
+      K k;
+      V v;
+      if (!Converter<K>::FromV8(isolate, key, &k) ||
+          !Converter<V>::FromV8(isolate, value, &v))
+        return false;
+      result.emplace_hint(result.end(), std::move(k), std::move(v));
+    }
+  }
+
+  out->swap(result);
+  return true;
+}
+
+}  // namespace internal
+
 template<typename T>
 struct Converter<std::set<T> > {
   static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
                                     const std::set<T>& val) {
     v8::Local<v8::Array> result(
         MATE_ARRAY_NEW(isolate, static_cast<int>(val.size())));
-    typename std::set<T>::const_iterator it;
-    int i;
-    for (i = 0, it = val.begin(); it != val.end(); ++it, ++i)
-         result->Set(i, Converter<T>::ToV8(isolate, *it));
+    internal::ElementsToV8<T>(isolate, val.begin(), val.end(), result);
     return result;
   }
 
   static bool FromV8(v8::Isolate* isolate,
                      v8::Local<v8::Value> val,
                      std::set<T>* out) {
-    if (!val->IsArray())
-      return false;
+    return internal::SetFromV8(isolate, val, out);
+  }
+};
 
-    std::set<T> result;
-    v8::Local<v8::Array> array(v8::Local<v8::Array>::Cast(val));
-    uint32_t length = array->Length();
-    for (uint32_t i = 0; i < length; ++i) {
-      T item;
-      if (!Converter<T>::FromV8(isolate, array->Get(i), &item))
-        return false;
-      result.push_back(item);
-    }
+template<typename T>
+struct Converter<std::unordered_set<T> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::unordered_set<T>& val) {
+    v8::Local<v8::Array> result(
+        MATE_ARRAY_NEW(isolate, static_cast<int>(val.size())));
+    internal::ElementsToV8<T>(isolate, val.begin(), val.end(), result);
+    return result;
+  }
 
-    out->swap(result);
-    return true;
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::unordered_set<T>* out) {
+    return internal::SetFromV8(isolate, val, out);
+  }
+};
+
+// Maps with std::string keys are converted to plain objects, other maps to
+// Maps. Both are accepted from JavaScript.
+template<typename K, typename V>
+struct Converter<std::map<K, V> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::map<K, V>& val) {
+    return internal::MapToV8(isolate, val, std::is_same<K, std::string>());
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::map<K, V>* out) {
+    return internal::MapFromV8(isolate, val, out);
+  }
+};
+
+template<typename K, typename V>
+struct Converter<std::unordered_map<K, V> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::unordered_map<K, V>& val) {
+    return internal::MapToV8(isolate, val, std::is_same<K, std::string>());
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::unordered_map<K, V>* out) {
+    return internal::MapFromV8(isolate, val, out);
   }
 };
 
@@ -4,6 +4,8 @@
 
 #include "native_mate/dictionary.h"
 
+#include "native_mate/per_isolate_data.h"
+
 namespace mate {
 
 Dictionary::Dictionary()
@@ -23,10 +25,20 @@ Dictionary Dictionary::CreateEmpty(v8::Isolate* isolate) {
   return Dictionary(isolate, v8::Object::New(isolate));;
 }
 
+Dictionary Dictionary::CreateEmpty(v8::Isolate* isolate,
+                                   const RecordTemplate& record) {
+  return Dictionary(isolate, record.NewInstance(isolate));
+}
+
 v8::Local<v8::Object> Dictionary::GetHandle() const {
   return object_;
 }
 
+v8::Local<v8::Private> Dictionary::GetPrivateKey(
+    const base::StringPiece& key) const {
+  return PerIsolateData::From(isolate_)->GetPrivateKey(key);
+}
+
 v8::Local<v8::Value> Converter<Dictionary>::ToV8(v8::Isolate* isolate,
                                                   Dictionary val) {
   return val.GetHandle();
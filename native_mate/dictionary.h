@@ -5,11 +5,25 @@
 #ifndef NATIVE_MATE_DICTIONARY_H_
 #define NATIVE_MATE_DICTIONARY_H_
 
+#include "base/logging.h"
 #include "native_mate/converter.h"
+#include "native_mate/key_set.h"
 #include "native_mate/object_template_builder.h"
+#include "native_mate/private_key.h"
+#include "native_mate/record_template.h"
 
 namespace mate {
 
+// Result of Dictionary::GetMany, bit i refers to the i-th key of the KeySet.
+struct FieldErrors {
+  FieldErrors() : missing(0), invalid(0) {}
+
+  bool ok() const { return (missing | invalid) == 0; }
+
+  uint32_t missing;  // The property is undefined.
+  uint32_t invalid;  // The property could not be converted.
+};
+
 // Dictionary is useful when writing bindings for a function that either
 // receives an arbitrary JavaScript object as an argument or returns an
 // arbitrary JavaScript object as a result. For example, Dictionary is useful
@@ -30,17 +44,44 @@ class Dictionary {
 
   static Dictionary CreateEmpty(v8::Isolate* isolate);
 
+  // Creates an object that already has the fields of |record|, so setting
+  // them does not transition the object's hidden class.
+  static Dictionary CreateEmpty(v8::Isolate* isolate,
+                                const RecordTemplate& record);
+
   template<typename T>
   bool Get(const base::StringPiece& key, T* out) const {
     v8::Local<v8::Value> val = GetHandle()->Get(StringToV8(isolate_, key));
     return ConvertFromV8(isolate_, val, out);
   }
 
+  // Reads the properties named by |keys| into |out|, in the order of the
+  // keys. Outputs of the fields reported in the returned FieldErrors are left
+  // untouched.
+  template<typename... Ts>
+  FieldErrors GetMany(const KeySet& keys, Ts*... out) const {
+    static_assert(sizeof...(Ts) > 0 && sizeof...(Ts) <= 32,
+                  "GetMany reads between 1 and 32 fields");
+    CHECK_EQ(keys.size(), sizeof...(Ts));
+    v8::Local<v8::String> names[sizeof...(Ts)];
+    keys.GetAll(isolate_, names);
+    FieldErrors errors;
+    GetFields(isolate_->GetCurrentContext(), GetHandle(), names, 0, &errors,
+              out...);
+    return errors;
+  }
+
+  // Hidden values are stored under private symbols, which are invisible to
+  // JavaScript and are accessed through V8's inline caches like regular
+  // properties.
+  // Hot paths should pass a static PrivateKey instead of a name.
   template<typename T>
   bool GetHidden(const base::StringPiece& key, T* out) const {
-    v8::Local<v8::Value> val = GetHandle()->GetHiddenValue(
-        StringToV8(isolate_, key));
-    return ConvertFromV8(isolate_, val, out);
+    return GetHidden(GetPrivateKey(key), out);
+  }
+  template<typename T>
+  bool GetHidden(const PrivateKey& key, T* out) const {
+    return GetHidden(key.Get(isolate_), out);
   }
 
   template<typename T>
@@ -49,10 +90,33 @@ class Dictionary {
                             ConvertToV8(isolate_, val));
   }
 
+  // Defines the properties named by |keys| with |vals| through
+  // CreateDataProperty, which does not run setters on the prototype chain.
+  template<typename... Ts>
+  bool SetMany(const KeySet& keys, const Ts&... vals) {
+    static_assert(sizeof...(Ts) > 0, "SetMany writes at least 1 field");
+    CHECK_EQ(keys.size(), sizeof...(Ts));
+    v8::Local<v8::String> names[sizeof...(Ts)];
+    keys.GetAll(isolate_, names);
+    v8::Local<v8::Value> values[] = { ConvertToV8(isolate_, vals)... };
+    v8::Local<v8::Context> context = isolate_->GetCurrentContext();
+    v8::Local<v8::Object> object = GetHandle();
+    bool success = true;
+    for (size_t i = 0; i < sizeof...(Ts); ++i) {
+      if (!object->CreateDataProperty(context, names[i], values[i])
+               .FromMaybe(false))
+        success = false;
+    }
+    return success;
+  }
+
   template<typename T>
   bool SetHidden(const base::StringPiece& key, T val) {
-    return GetHandle()->SetHiddenValue(StringToV8(isolate_, key),
-                                       ConvertToV8(isolate_, val));
+    return SetHidden(GetPrivateKey(key), val);
+  }
+  template<typename T>
+  bool SetHidden(const PrivateKey& key, T val) {
+    return SetHidden(key.Get(isolate_), val);
   }
 
   template<typename T>
@@ -72,6 +136,45 @@ class Dictionary {
   v8::Isolate* isolate_;
 
  private:
+  v8::Local<v8::Private> GetPrivateKey(const base::StringPiece& key) const;
+
+  template<typename T>
+  bool GetHidden(v8::Local<v8::Private> key, T* out) const {
+    v8::Local<v8::Value> val;
+    if (!GetHandle()->GetPrivate(isolate_->GetCurrentContext(), key)
+             .ToLocal(&val))
+      return false;
+    return ConvertFromV8(isolate_, val, out);
+  }
+
+  template<typename T>
+  bool SetHidden(v8::Local<v8::Private> key, T val) {
+    return GetHandle()->SetPrivate(isolate_->GetCurrentContext(), key,
+                                   ConvertToV8(isolate_, val)).FromMaybe(false);
+  }
+
+  template<typename T, typename... Ts>
+  void GetFields(v8::Local<v8::Context> context,
+                 v8::Local<v8::Object> object,
+                 const v8::Local<v8::String>* names,
+                 size_t index,
+                 FieldErrors* errors,
+                 T* out,
+                 Ts*... rest) const {
+    v8::Local<v8::Value> val;
+    if (!object->Get(context, names[index]).ToLocal(&val) ||
+        val->IsUndefined())
+      errors->missing |= 1u << index;
+    else if (!ConvertFromV8(isolate_, val, out))
+      errors->invalid |= 1u << index;
+    GetFields(context, object, names, index + 1, errors, rest...);
+  }
+  void GetFields(v8::Local<v8::Context> context,
+                 v8::Local<v8::Object> object,
+                 const v8::Local<v8::String>* names,
+                 size_t index,
+                 FieldErrors* errors) const {}
+
   v8::Local<v8::Object> object_;
 };
 
@@ -0,0 +1,28 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/enum_converter.h"
+
+namespace mate {
+
+namespace internal {
+
+bool ReadEnumName(v8::Local<v8::Value> val,
+                  uint16_t* buffer,
+                  size_t capacity,
+                  size_t* length) {
+  if (!val->IsString())
+    return false;
+  v8::Local<v8::String> str = v8::Local<v8::String>::Cast(val);
+  int str_length = str->Length();
+  if (static_cast<size_t>(str_length) > capacity)
+    return false;
+  str->Write(buffer, 0, str_length, v8::String::NO_NULL_TERMINATION);
+  *length = str_length;
+  return true;
+}
+
+}  // namespace internal
+
+}  // namespace mate
@@ -0,0 +1,137 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_ENUM_CONVERTER_H_
+#define NATIVE_MATE_ENUM_CONVERTER_H_
+
+#include <stdint.h>
+
+#include <tuple>
+
+#include "native_mate/converter.h"
+#include "native_mate/key_set.h"
+
+namespace mate {
+
+// MATE_ENUM generates the Converter of an enum from a list of its values and
+// their names in JavaScript. It must be used in the global namespace:
+//
+//   enum class Quality { LOW, HIGH };
+//   MATE_ENUM(Quality, MATE_ENUM_VALUE(LOW, "low"),
+//                      MATE_ENUM_VALUE(HIGH, "high"))
+//
+// ToV8 returns the name as an internalized string cached per isolate. FromV8
+// copies the characters of the JavaScript string to the stack, without
+// creating a std::string, and compares them with the names that have the
+// same length and first character. Names are at most kMaxEnumNameLength
+// characters of ASCII.
+#define MATE_ENUM(type, ...)                                               \
+  namespace mate {                                                         \
+  template<>                                                               \
+  struct EnumTraits<type> {                                                \
+    typedef type Type;                                                     \
+    static const size_t kCount =                                           \
+        std::tuple_size<decltype(std::make_tuple(__VA_ARGS__))>::value;    \
+    static const internal::EnumValue<type>* GetValues() {                  \
+      static const internal::EnumValue<type> values[] = { __VA_ARGS__ };   \
+      return values;                                                       \
+    }                                                                      \
+  };                                                                       \
+  template<>                                                               \
+  struct Converter<type> : public internal::EnumConverter<type> {};       \
+  }
+
+#define MATE_ENUM_VALUE(value, name) \
+  ::mate::internal::MakeEnumValue(name, Type::value)
+
+// Longest name of an enum value.
+const size_t kMaxEnumNameLength = 64;
+
+// Specialized by MATE_ENUM, provides the values of the enum and their names.
+template<typename T>
+struct EnumTraits {};
+
+namespace internal {
+
+template<typename T>
+struct EnumValue {
+  const char* name;
+  size_t length;
+  T value;
+};
+
+template<typename T, size_t N>
+constexpr EnumValue<T> MakeEnumValue(const char (&name)[N], T value) {
+  static_assert(N > 1 && N - 1 <= kMaxEnumNameLength,
+                "Enum names must have 1 to kMaxEnumNameLength characters");
+  return EnumValue<T>{ name, N - 1, value };
+}
+
+// Copies the characters of |val| into |buffer| and sets |length|. Returns
+// false when |val| is not a string or is longer than |capacity|.
+bool ReadEnumName(v8::Local<v8::Value> val,
+                  uint16_t* buffer,
+                  size_t capacity,
+                  size_t* length);
+
+template<typename T>
+struct EnumConverter {
+  typedef EnumTraits<T> Traits;
+
+  static_assert(Traits::kCount > 0, "MATE_ENUM needs at least one value");
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, T val) {
+    const EnumValue<T>* values = Traits::GetValues();
+    for (size_t i = 0; i < Traits::kCount; ++i) {
+      if (values[i].value == val)
+        return GetKeySet().Get(isolate, i);
+    }
+    return MATE_UNDEFINED(isolate);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     T* out) {
+    uint16_t buffer[kMaxEnumNameLength];
+    size_t length;
+    if (!ReadEnumName(val, buffer, kMaxEnumNameLength, &length) ||
+        length == 0)
+      return false;
+    const EnumValue<T>* values = Traits::GetValues();
+    for (size_t i = 0; i < Traits::kCount; ++i) {
+      if (values[i].length == length &&
+          static_cast<unsigned char>(values[i].name[0]) == buffer[0] &&
+          Equals(values[i].name, buffer, length)) {
+        *out = values[i].value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // The key set only holds constants, so it is initialized statically.
+  static const KeySet& GetKeySet() {
+    static const KeySet keys(&GetName, Traits::kCount);
+    return keys;
+  }
+
+  static const char* GetName(size_t index) {
+    return Traits::GetValues()[index].name;
+  }
+
+ private:
+  static bool Equals(const char* name, const uint16_t* chars, size_t length) {
+    for (size_t i = 1; i < length; ++i) {
+      if (static_cast<unsigned char>(name[i]) != chars[i])
+        return false;
+    }
+    return true;
+  }
+};
+
+}  // namespace internal
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_ENUM_CONVERTER_H_
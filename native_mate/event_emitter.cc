@@ -0,0 +1,225 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/event_emitter.h"
+
+#include "native_mate/arguments.h"
+#include "native_mate/object_template_builder.h"
+#include "native_mate/per_isolate_data.h"
+#include "native_mate/private_key.h"
+
+namespace mate {
+
+namespace {
+
+const PrivateKey kListenersKey("mate::EventEmitter::listeners");
+
+// Addresses of the method templates in PerIsolateData.
+const char kAddListenerKey = 0;
+const char kRemoveListenerKey = 0;
+const char kRemoveAllListenersKey = 0;
+const char kListenerCountKey = 0;
+
+// Returns the template of |method|, created once per isolate, so each
+// emitter's template only adds the cached functions.
+template<typename T>
+v8::Local<v8::FunctionTemplate> GetMethodTemplate(v8::Isolate* isolate,
+                                                  const char* key,
+                                                  const char* name,
+                                                  T method) {
+  PerIsolateData* data = PerIsolateData::From(isolate);
+  v8::Local<v8::FunctionTemplate> templ = data->GetFunctionTemplate(key);
+  if (templ.IsEmpty()) {
+    MATE_BINDING_STATS_SCOPE(isolate, "", name);
+    templ = CallbackTraits<T>::CreateTemplate(isolate, method);
+    data->SetFunctionTemplate(key, templ);
+  }
+  return templ;
+}
+
+}  // namespace
+
+EventEmitter::EventEmitter() {
+}
+
+EventEmitter::~EventEmitter() {
+  listeners_.Reset();
+}
+
+uint32_t EventEmitter::ListenerCount(const std::string& name) const {
+  int index = FindEvent(name);
+  return index < 0 ? 0 : events_[index].count;
+}
+
+// static
+void EventEmitter::BuildPrototype(v8::Isolate* isolate,
+                                  v8::Local<v8::ObjectTemplate> prototype) {
+  v8::Local<v8::FunctionTemplate> add_listener = GetMethodTemplate(
+      isolate, &kAddListenerKey, "addListener", &EventEmitter::AddListener);
+  ObjectTemplateBuilder(isolate, prototype)
+      .SetMethod("on", add_listener)
+      .SetMethod("addListener", add_listener)
+      .SetMethod("removeListener",
+                 GetMethodTemplate(isolate, &kRemoveListenerKey,
+                                   "removeListener",
+                                   &EventEmitter::RemoveListener))
+      .SetMethod("removeAllListeners",
+                 GetMethodTemplate(isolate, &kRemoveAllListenersKey,
+                                   "removeAllListeners",
+                                   &EventEmitter::RemoveAllListeners))
+      .SetMethod("listenerCount",
+                 GetMethodTemplate(isolate, &kListenerCountKey,
+                                   "listenerCount",
+                                   &EventEmitter::ListenerCount));
+}
+
+ObjectTemplateBuilder EventEmitter::GetObjectTemplateBuilder(
+    v8::Isolate* isolate) {
+  v8::Local<v8::ObjectTemplate> templ = v8::ObjectTemplate::New(isolate);
+  BuildPrototype(isolate, templ);
+  return ObjectTemplateBuilder(isolate, templ);
+}
+
+v8::Local<v8::Object> EventEmitter::AddListener(
+    const std::string& name, v8::Local<v8::Function> listener) {
+  v8::Isolate* isolate = this->isolate();
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  int index = FindEvent(name);
+  if (index < 0) {
+    Event event = { name, 0 };
+    index = static_cast<int>(events_.size());
+    events_.push_back(event);
+  }
+
+  uint32_t count = events_[index].count;
+  v8::Local<v8::Array> old_listeners = GetListeners(context, index);
+  v8::Local<v8::Array> listeners = MATE_ARRAY_NEW(isolate, count + 1);
+  for (uint32_t i = 0; i < count; ++i) {
+    if (!listeners->CreateDataProperty(
+            context, i, old_listeners->Get(context, i).ToLocalChecked())
+            .FromMaybe(false))
+      return GetWrapper(isolate);
+  }
+  if (listeners->CreateDataProperty(context, count, listener).FromMaybe(false))
+    SetListeners(context, index, listeners, count + 1);
+  return GetWrapper(isolate);
+}
+
+v8::Local<v8::Object> EventEmitter::RemoveListener(
+    const std::string& name, v8::Local<v8::Function> listener) {
+  v8::Isolate* isolate = this->isolate();
+  int index = FindEvent(name);
+  if (index < 0 || events_[index].count == 0)
+    return GetWrapper(isolate);
+
+  // Like Node.js, the most recently added instance of |listener| is removed.
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  uint32_t count = events_[index].count;
+  v8::Local<v8::Array> old_listeners = GetListeners(context, index);
+  uint32_t position = count;
+  while (position > 0) {
+    if (old_listeners->Get(context, position - 1).ToLocalChecked()
+            ->StrictEquals(listener))
+      break;
+    --position;
+  }
+  if (position == 0)
+    return GetWrapper(isolate);
+  --position;
+
+  if (count == 1) {
+    SetListeners(context, index, MATE_UNDEFINED(isolate), 0);
+    return GetWrapper(isolate);
+  }
+  v8::Local<v8::Array> listeners = MATE_ARRAY_NEW(isolate, count - 1);
+  for (uint32_t i = 0, j = 0; i < count; ++i) {
+    if (i == position)
+      continue;
+    if (!listeners->CreateDataProperty(
+            context, j++, old_listeners->Get(context, i).ToLocalChecked())
+            .FromMaybe(false))
+      return GetWrapper(isolate);
+  }
+  SetListeners(context, index, listeners, count - 1);
+  return GetWrapper(isolate);
+}
+
+v8::Local<v8::Object> EventEmitter::RemoveAllListeners(Arguments* args) {
+  v8::Isolate* isolate = this->isolate();
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  std::string name;
+  if (args->GetNext(&name)) {
+    int index = FindEvent(name);
+    if (index >= 0)
+      SetListeners(context, index, MATE_UNDEFINED(isolate), 0);
+  } else {
+    for (size_t i = 0; i < events_.size(); ++i)
+      SetListeners(context, static_cast<int>(i), MATE_UNDEFINED(isolate), 0);
+  }
+  return GetWrapper(isolate);
+}
+
+int EventEmitter::FindEvent(const base::StringPiece& name) const {
+  for (size_t i = 0; i < events_.size(); ++i) {
+    if (name == events_[i].name)
+      return static_cast<int>(i);
+  }
+  return -1;
+}
+
+v8::Local<v8::Array> EventEmitter::GetListenerTable(v8::Isolate* isolate) {
+  if (!listeners_.IsEmpty())
+    return v8::Local<v8::Array>::New(isolate, listeners_);
+
+  v8::Local<v8::Object> wrapper = GetWrapper(isolate);
+  v8::Local<v8::Array> table = MATE_ARRAY_NEW(isolate, 0);
+  if (!wrapper->SetPrivate(wrapper->CreationContext(),
+                           kListenersKey.Get(isolate),
+                           table).FromMaybe(false))
+    return table;
+  listeners_.Reset(isolate, table);
+  listeners_.SetWeak();
+  return table;
+}
+
+v8::Local<v8::Array> EventEmitter::GetListeners(
+    v8::Local<v8::Context> context, int index) {
+  v8::Isolate* isolate = context->GetIsolate();
+  v8::Local<v8::Value> listeners;
+  if (!GetListenerTable(isolate)->Get(context, index).ToLocal(&listeners) ||
+      !listeners->IsArray())
+    return MATE_ARRAY_NEW(isolate, 0);
+  return v8::Local<v8::Array>::Cast(listeners);
+}
+
+void EventEmitter::SetListeners(v8::Local<v8::Context> context,
+                                int index,
+                                v8::Local<v8::Value> listeners,
+                                uint32_t count) {
+  if (GetListenerTable(context->GetIsolate())
+          ->CreateDataProperty(context, index, listeners).FromMaybe(false))
+    events_[index].count = count;
+}
+
+void EventEmitter::EmitWithArgs(v8::Local<v8::Context> context,
+                                v8::Local<v8::Object> wrapper,
+                                int index,
+                                int argc,
+                                v8::Local<v8::Value>* argv) {
+  // The array is never modified once it is set, listeners added or removed
+  // by a listener take effect from the next emission.
+  v8::Local<v8::Array> listeners = GetListeners(context, index);
+  uint32_t count = listeners->Length();
+  for (uint32_t i = 0; i < count; ++i) {
+    v8::Local<v8::Value> listener;
+    if (!listeners->Get(context, i).ToLocal(&listener) ||
+        !listener->IsFunction())
+      continue;
+    if (v8::Local<v8::Function>::Cast(listener)
+            ->Call(context, wrapper, argc, argv).IsEmpty())
+      return;
+  }
+}
+
+}  // namespace mate
@@ -0,0 +1,114 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_EVENT_EMITTER_H_
+#define NATIVE_MATE_EVENT_EMITTER_H_
+
+#include <string>
+#include <vector>
+
+#include "base/strings/string_piece.h"
+#include "native_mate/converter.h"
+#include "native_mate/wrappable.h"
+
+namespace mate {
+
+class Arguments;
+
+// EventEmitter is a Wrappable that keeps its JavaScript listeners itself, so
+// events can be emitted from C++ without going through the "emit" property:
+//
+//   class Download : public mate::EventEmitter {
+//     void OnProgress(int64_t received, int64_t total) {
+//       Emit("progress", received, total);
+//     }
+//   };
+//
+// JavaScript registers listeners with on/addListener, removeListener,
+// removeAllListeners and listenerCount. The arguments of Emit are converted
+// once and the same argv is passed to every listener, with the wrapper as
+// |this|. Adding or removing a listener replaces the event's listener array,
+// so an emission in progress is not affected and emitting never allocates
+// anything besides the converted arguments.
+class EventEmitter : public Wrappable {
+ public:
+  // Emits |name| and returns whether it had listeners. Stops at the first
+  // listener that throws, the exception is left to the caller's TryCatch.
+  template<typename... Args>
+  bool Emit(const base::StringPiece& name, const Args&... args) {
+    int index = FindEvent(name);
+    if (index < 0 || events_[index].count == 0)
+      return false;
+
+    v8::Isolate* isolate = this->isolate();
+    v8::HandleScope handle_scope(isolate);
+    v8::Local<v8::Object> wrapper = GetWrapper(isolate);
+    v8::Local<v8::Context> context = wrapper->CreationContext();
+    v8::Context::Scope context_scope(context);
+    v8::Local<v8::Value> argv[] = {
+      ConvertToV8(isolate, args)..., v8::Local<v8::Value>()
+    };
+    EmitWithArgs(context, wrapper, index, sizeof...(Args), argv);
+    return true;
+  }
+
+  // Returns the number of listeners of |name|.
+  uint32_t ListenerCount(const std::string& name) const;
+
+  static void BuildPrototype(v8::Isolate* isolate,
+                             v8::Local<v8::ObjectTemplate> prototype);
+
+ protected:
+  EventEmitter();
+  ~EventEmitter() override;
+
+  // Returns a new template with the emitter methods, which subclasses may
+  // add their own methods to. The function templates of the methods are
+  // created once per isolate and shared, subclasses that want to avoid the
+  // new ObjectTemplate too can cache their own one, built with
+  // BuildPrototype.
+  ObjectTemplateBuilder GetObjectTemplateBuilder(
+      v8::Isolate* isolate) override;
+
+ private:
+  struct Event {
+    std::string name;
+    uint32_t count;
+  };
+
+  // Methods of the JavaScript object.
+  v8::Local<v8::Object> AddListener(const std::string& name,
+                                    v8::Local<v8::Function> listener);
+  v8::Local<v8::Object> RemoveListener(const std::string& name,
+                                       v8::Local<v8::Function> listener);
+  v8::Local<v8::Object> RemoveAllListeners(Arguments* args);
+
+  int FindEvent(const base::StringPiece& name) const;
+  v8::Local<v8::Array> GetListenerTable(v8::Isolate* isolate);
+  v8::Local<v8::Array> GetListeners(v8::Local<v8::Context> context,
+                                    int index);
+  void SetListeners(v8::Local<v8::Context> context,
+                    int index,
+                    v8::Local<v8::Value> listeners,
+                    uint32_t count);
+  void EmitWithArgs(v8::Local<v8::Context> context,
+                    v8::Local<v8::Object> wrapper,
+                    int index,
+                    int argc,
+                    v8::Local<v8::Value>* argv);
+
+  // The names and listener counts of the events, in the order of |listeners_|.
+  std::vector<Event> events_;
+
+  // Array of the listener arrays of each event. It is stored in a private
+  // property of the wrapper, so listeners that reference the wrapper do not
+  // keep it alive, and this handle is weak.
+  v8::UniquePersistent<v8::Array> listeners_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventEmitter);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_EVENT_EMITTER_H_
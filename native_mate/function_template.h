@@ -5,12 +5,19 @@
 #ifndef NATIVE_MATE_FUNCTION_TEMPLATE_H_
 #define NATIVE_MATE_FUNCTION_TEMPLATE_H_
 
+#include <utility>
+
 #include "base/callback.h"
 #include "base/logging.h"
 #include "native_mate/arguments.h"
+#include "native_mate/binding_stats.h"
 #include "native_mate/wrappable.h"
 #include "v8/include/v8.h"
 
+#if MATE_HAS_CXX17
+#include <optional>
+#endif
+
 namespace mate {
 
 enum CreateFunctionTemplateFlags {
@@ -81,9 +88,16 @@ class CallbackHolder : public CallbackHolderBase {
   CallbackHolder(v8::Isolate* isolate,
                  const base::Callback<Sig>& callback,
                  int flags)
-      : CallbackHolderBase(isolate), callback(callback), flags(flags) {}
+      : CallbackHolderBase(isolate), callback(callback), flags(flags) {
+#if MATE_ENABLE_BINDING_STATS
+    stats = GetCurrentBindingStats(isolate);
+#endif
+  }
   base::Callback<Sig> callback;
   int flags;
+#if MATE_ENABLE_BINDING_STATS
+  BindingStats* stats;
+#endif
  private:
   virtual ~CallbackHolder() {}
 
@@ -120,6 +134,20 @@ inline bool GetNextArgument(Arguments* args, int create_flags,
   return true;
 }
 
+#if MATE_HAS_CXX17
+// An optional argument may be left out at the end of the call. Binding one
+// needs the converter in native_mate/variant_converter.h.
+template<typename T>
+bool GetNextArgument(Arguments* args, int create_flags, bool is_first,
+                     std::optional<T>* result) {
+  if (args->PeekNext().IsEmpty()) {
+    result->reset();
+    return true;
+  }
+  return args->GetNext(result);
+}
+#endif
+
 // Classes for generating and storing an argument pack of integer indices
 // (based on well-known "indices trick", see: http://goo.gl/bKKojn):
 template <size_t... indices>
@@ -192,7 +220,14 @@ class Invoker<IndicesHolder<indices...>, ArgTypes...>
 
   template <typename ReturnType>
   void DispatchToCallback(base::Callback<ReturnType(ArgTypes...)> callback) {
+#if MATE_ENABLE_BINDING_STATS
+    ReturnType result =
+        callback.Run(ArgumentHolder<indices, ArgTypes>::value...);
+    timer_->Mark();
+    args_->Return(std::move(result));
+#else
     args_->Return(callback.Run(ArgumentHolder<indices, ArgTypes>::value...));
+#endif
   }
 
   // In C++, you can declare the function foo(void), but you can't pass a void
@@ -200,8 +235,15 @@ class Invoker<IndicesHolder<indices...>, ArgTypes...>
   // that have the void return type.
   void DispatchToCallback(base::Callback<void(ArgTypes...)> callback) {
     callback.Run(ArgumentHolder<indices, ArgTypes>::value...);
+#if MATE_ENABLE_BINDING_STATS
+    timer_->Mark();
+#endif
   }
 
+#if MATE_ENABLE_BINDING_STATS
+  void set_timer(BindingCallTimer* timer) { timer_ = timer; }
+#endif
+
  private:
   static bool And() { return true; }
   template <typename... T>
@@ -210,6 +252,9 @@ class Invoker<IndicesHolder<indices...>, ArgTypes...>
   }
 
   Arguments* args_;
+#if MATE_ENABLE_BINDING_STATS
+  BindingCallTimer* timer_;
+#endif
 };
 
 // DispatchToCallback converts all the JavaScript arguments to C++ types and
@@ -231,9 +276,20 @@ struct Dispatcher<ReturnType(ArgTypes...)> {
     HolderT* holder = static_cast<HolderT*>(holder_base);
 
     using Indices = typename IndicesGenerator<sizeof...(ArgTypes)>::type;
+#if MATE_ENABLE_BINDING_STATS
+    BindingCallTimer timer(holder->stats);
+#endif
     Invoker<Indices, ArgTypes...> invoker(&args, holder->flags);
+#if MATE_ENABLE_BINDING_STATS
+    timer.Mark();
+    invoker.set_timer(&timer);
+#endif
     if (invoker.IsOK())
       invoker.DispatchToCallback(holder->callback);
+#if MATE_ENABLE_BINDING_STATS
+    else
+      timer.Fail();
+#endif
   }
 };
 
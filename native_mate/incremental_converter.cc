@@ -0,0 +1,146 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/incremental_converter.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/thread_task_runner_handle.h"
+#include "native_mate/microtasks.h"
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+// Number of elements converted or completed between two reads of the
+// clock.
+const size_t kStepsPerClockCheck = 64;
+
+}  // namespace
+
+IncrementalConversion::IncrementalConversion(
+    std::unique_ptr<IncrementalSequence> sequence,
+    base::TimeDelta slice_budget)
+    : isolate_(NULL),
+      slice_budget_(slice_budget) {
+  PushFrame(std::move(sequence));
+}
+
+IncrementalConversion::~IncrementalConversion() {
+  resolver_.Reset();
+  result_.Reset();
+}
+
+v8::Local<v8::Object> IncrementalConversion::Start(v8::Isolate* isolate) {
+  v8::EscapableHandleScope handle_scope(isolate);
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Promise::Resolver> resolver;
+  if (!v8::Promise::Resolver::New(context).ToLocal(&resolver))
+    return v8::Local<v8::Object>();
+
+  isolate_ = isolate;
+  task_runner_ = base::ThreadTaskRunnerHandle::Get();
+  resolver_.Reset(isolate, resolver);
+  // The arrays are created once there is an isolate.
+  Frame* frame = frames_.front().get();
+  frame->array.Reset(isolate, MATE_ARRAY_NEW(
+      isolate, static_cast<int>(frame->sequence->size())));
+  result_.Reset(isolate, v8::Local<v8::Array>::New(isolate, frame->array));
+  task_runner_->PostTask(
+      FROM_HERE, base::Bind(&IncrementalConversion::RunSlice, this));
+  return handle_scope.Escape(resolver->GetPromise());
+}
+
+void IncrementalConversion::PushFrame(
+    std::unique_ptr<IncrementalSequence> sequence) {
+  std::unique_ptr<Frame> frame(new Frame);
+  if (isolate_) {
+    frame->array.Reset(isolate_, MATE_ARRAY_NEW(
+        isolate_, static_cast<int>(sequence->size())));
+  }
+  frame->sequence = std::move(sequence);
+  frame->next = 0;
+  frames_.push_back(std::move(frame));
+}
+
+bool IncrementalConversion::Step(v8::Local<v8::Context> context) {
+  Frame* frame = frames_.back().get();
+  v8::Local<v8::Value> value;
+  if (frame->next < frame->sequence->size()) {
+    std::unique_ptr<IncrementalSequence> nested;
+    value = frame->sequence->ConvertAt(isolate_, frame->next, &nested);
+    if (nested) {
+      PushFrame(std::move(nested));
+      return true;
+    }
+  } else {
+    // The sequence is complete, its array is the next element of the parent.
+    value = v8::Local<v8::Array>::New(isolate_, frame->array);
+    frames_.pop_back();
+    if (frames_.empty())
+      return true;
+    frame = frames_.back().get();
+  }
+  if (value.IsEmpty() ||
+      !v8::Local<v8::Array>::New(isolate_, frame->array)
+           ->CreateDataProperty(context, static_cast<uint32_t>(frame->next),
+                                value)
+           .FromMaybe(false))
+    return false;
+  ++frame->next;
+  return true;
+}
+
+void IncrementalConversion::RunSlice() {
+  {
+    v8::HandleScope handle_scope(isolate_);
+    v8::Local<v8::Promise::Resolver> resolver =
+        v8::Local<v8::Promise::Resolver>::New(isolate_, resolver_);
+    v8::Local<v8::Context> context = resolver->CreationContext();
+    v8::Context::Scope context_scope(context);
+
+    bool failed = false;
+    base::TimeTicks deadline = base::TimeTicks::Now() + slice_budget_;
+    while (!frames_.empty() && !failed) {
+      {
+        // Handles of converted elements are released every few steps.
+        v8::HandleScope element_scope(isolate_);
+        for (size_t i = 0; i < kStepsPerClockCheck && !frames_.empty(); ++i) {
+          if (!Step(context)) {
+            failed = true;
+            break;
+          }
+        }
+      }
+      if (base::TimeTicks::Now() >= deadline)
+        break;
+    }
+
+    if (!failed && !frames_.empty()) {
+      task_runner_->PostTask(
+          FROM_HERE, base::Bind(&IncrementalConversion::RunSlice, this));
+      return;
+    }
+
+    frames_.clear();
+    if (!failed)
+      ignore_result(resolver->Resolve(
+          context, v8::Local<v8::Array>::New(isolate_, result_)));
+    else
+      ignore_result(resolver->Reject(
+          context, v8::Exception::Error(StringToV8(
+                       isolate_, "Failed to convert the value"))));
+    resolver_.Reset();
+    result_.Reset();
+  }
+  RunMicrotasks(isolate_);
+}
+
+}  // namespace internal
+
+}  // namespace mate
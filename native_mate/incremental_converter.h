@@ -0,0 +1,157 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_INCREMENTAL_CONVERTER_H_
+#define NATIVE_MATE_INCREMENTAL_CONVERTER_H_
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "base/single_thread_task_runner.h"
+#include "base/time/time.h"
+#include "native_mate/converter.h"
+
+namespace mate {
+
+namespace internal {
+
+// A sequence whose elements are converted over several slices.
+class IncrementalSequence {
+ public:
+  virtual ~IncrementalSequence() {}
+
+  virtual size_t size() const = 0;
+
+  // Converts the element at |index|. An element that is a sequence itself
+  // is not converted, it is returned in |nested| to be converted in slices
+  // too and the result is empty.
+  virtual v8::Local<v8::Value> ConvertAt(
+      v8::Isolate* isolate,
+      size_t index,
+      std::unique_ptr<IncrementalSequence>* nested) = 0;
+};
+
+template<typename T>
+class VectorSequence;
+
+template<typename T>
+v8::Local<v8::Value> ConvertElement(
+    v8::Isolate* isolate,
+    T* value,
+    std::unique_ptr<IncrementalSequence>* nested) {
+  return ConvertToV8(isolate, *value);
+}
+
+// Nested vectors are converted in slices like the outer one, unless they
+// have a converter of their own.
+template<typename T>
+v8::Local<v8::Value> ConvertElement(
+    v8::Isolate* isolate,
+    std::vector<T>* value,
+    std::unique_ptr<IncrementalSequence>* nested) {
+  if (!IsElementwiseVector<T>::value)
+    return ConvertToV8(isolate, *value);
+  nested->reset(new VectorSequence<T>(std::move(*value)));
+  return v8::Local<v8::Value>();
+}
+
+template<typename T>
+class VectorSequence : public IncrementalSequence {
+ public:
+  explicit VectorSequence(std::vector<T> values)
+      : values_(std::move(values)) {}
+
+  size_t size() const override { return values_.size(); }
+
+  v8::Local<v8::Value> ConvertAt(
+      v8::Isolate* isolate,
+      size_t index,
+      std::unique_ptr<IncrementalSequence>* nested) override {
+    return ConvertElement(isolate, &values_[index], nested);
+  }
+
+ private:
+  std::vector<T> values_;
+
+  DISALLOW_COPY_AND_ASSIGN(VectorSequence);
+};
+
+// Converts a sequence into a JavaScript array over several tasks, each one
+// running in its own HandleScope for at most |slice_budget|, and resolves a
+// promise with the array at the end. Nested sequences are converted the
+// same way, depth first, before they are set in their parent. The arrays
+// being filled and the resolver are kept in persistent handles between the
+// tasks.
+class IncrementalConversion
+    : public base::RefCounted<IncrementalConversion> {
+ public:
+  IncrementalConversion(std::unique_ptr<IncrementalSequence> sequence,
+                        base::TimeDelta slice_budget);
+
+  // Starts the conversion and returns the promise of its result.
+  v8::Local<v8::Object> Start(v8::Isolate* isolate);
+
+ private:
+  friend class base::RefCounted<IncrementalConversion>;
+
+  // A sequence being converted and the array it is converted into.
+  struct Frame {
+    std::unique_ptr<IncrementalSequence> sequence;
+    v8::UniquePersistent<v8::Array> array;
+    size_t next;
+  };
+
+  ~IncrementalConversion();
+
+  void PushFrame(std::unique_ptr<IncrementalSequence> sequence);
+
+  // Converts the next element of the innermost sequence, or sets its array
+  // in the parent once it is complete. Returns false on failure.
+  bool Step(v8::Local<v8::Context> context);
+
+  void RunSlice();
+
+  v8::Isolate* isolate_;
+  const base::TimeDelta slice_budget_;
+  // Each sequence is owned by its frame and released once it is converted.
+  std::vector<std::unique_ptr<Frame> > frames_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  v8::UniquePersistent<v8::Promise::Resolver> resolver_;
+  v8::UniquePersistent<v8::Array> result_;
+
+  DISALLOW_COPY_AND_ASSIGN(IncrementalConversion);
+};
+
+}  // namespace internal
+
+// Converts |values| to a JavaScript array without blocking the thread for
+// the whole conversion, and returns a promise of the array:
+//
+//   return mate::ConvertIncrementally(isolate, std::move(rows));
+//
+// The elements are converted with Converter<T>::ToV8 in slices of at most
+// |slice_budget|, with a posted task between two slices so other tasks can
+// run. Elements that are vectors are sliced the same way, so a vector of
+// rows is not converted a whole row at a time. Any other element is the
+// smallest unit, one that takes longer than the budget to convert still
+// runs in one slice. The promise is resolved from a task, the microtasks are
+// run after it.
+template<typename T>
+v8::Local<v8::Object> ConvertIncrementally(
+    v8::Isolate* isolate,
+    std::vector<T> values,
+    base::TimeDelta slice_budget = base::TimeDelta::FromMilliseconds(4)) {
+  scoped_refptr<internal::IncrementalConversion> conversion(
+      new internal::IncrementalConversion(
+          std::unique_ptr<internal::IncrementalSequence>(
+              new internal::VectorSequence<T>(std::move(values))),
+          slice_budget));
+  return conversion->Start(isolate);
+}
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_INCREMENTAL_CONVERTER_H_
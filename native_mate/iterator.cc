@@ -0,0 +1,85 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/iterator.h"
+
+#include "native_mate/object_template_builder.h"
+#include "native_mate/per_isolate_data.h"
+#include "native_mate/record_template.h"
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+const char* const kIteratorResultNames[] = { "value", "done" };
+const KeySet kIteratorResultKeys(kIteratorResultNames);
+const RecordTemplate kIteratorResultTemplate(kIteratorResultKeys);
+
+// Address of the iterator template in PerIsolateData.
+const char kIteratorTemplateKey = 0;
+
+}  // namespace
+
+v8::Local<v8::Object> NewIteratorResult(v8::Isolate* isolate,
+                                        v8::Local<v8::Value> value,
+                                        bool done) {
+  v8::Local<v8::Value> result[] = {
+    value, done ? MATE_TRUE(isolate) : MATE_FALSE(isolate)
+  };
+  return kIteratorResultTemplate.NewWithValues(isolate, result);
+}
+
+IteratorBase::IteratorBase() : done_(false) {
+}
+
+IteratorBase::~IteratorBase() {
+}
+
+ObjectTemplateBuilder IteratorBase::GetObjectTemplateBuilder(
+    v8::Isolate* isolate) {
+  PerIsolateData* data = PerIsolateData::From(isolate);
+  v8::Local<v8::ObjectTemplate> templ =
+      data->GetObjectTemplate(&kIteratorTemplateKey);
+  if (templ.IsEmpty()) {
+    templ = ObjectTemplateBuilder(isolate)
+        .SetMethod("next", &IteratorBase::Next)
+        .SetMethod("return", &IteratorBase::Return)
+        .Build();
+    templ->Set(v8::Symbol::GetIterator(isolate),
+               CreateFunctionTemplate(isolate,
+                                      base::Bind(&IteratorBase::GetIterator),
+                                      HolderIsFirstArgument));
+    data->SetObjectTemplate(&kIteratorTemplateKey, templ);
+  }
+  return ObjectTemplateBuilder(isolate, templ);
+}
+
+v8::Local<v8::Object> IteratorBase::Next(v8::Isolate* isolate) {
+  v8::Local<v8::Value> value;
+  if (done_ || !Advance(isolate, &value))
+    return Done(isolate);
+  return NewIteratorResult(isolate, value, false);
+}
+
+v8::Local<v8::Object> IteratorBase::Return(v8::Isolate* isolate) {
+  return Done(isolate);
+}
+
+v8::Local<v8::Object> IteratorBase::GetIterator(v8::Isolate* isolate) {
+  return GetWrapper(isolate);
+}
+
+v8::Local<v8::Object> IteratorBase::Done(v8::Isolate* isolate) {
+  if (!done_) {
+    done_ = true;
+    Finish();
+  }
+  return NewIteratorResult(isolate, MATE_UNDEFINED(isolate), true);
+}
+
+}  // namespace internal
+
+}  // namespace mate
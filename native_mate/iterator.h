@@ -0,0 +1,181 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_ITERATOR_H_
+#define NATIVE_MATE_ITERATOR_H_
+
+#include <deque>
+#include <iterator>
+#include <list>
+#include <type_traits>
+#include <utility>
+
+#include "base/callback.h"
+#include "native_mate/converter.h"
+#include "native_mate/wrappable.h"
+
+namespace mate {
+
+namespace internal {
+
+// Returns an iterator result object, { value, done }.
+v8::Local<v8::Object> NewIteratorResult(v8::Isolate* isolate,
+                                        v8::Local<v8::Value> value,
+                                        bool done);
+
+// The JavaScript side of the iterators returned by CreateIterator: an object
+// with next(), return() and [Symbol.iterator](), whose results share one
+// hidden class.
+class IteratorBase : public Wrappable {
+ protected:
+  IteratorBase();
+  ~IteratorBase() override;
+
+  // Converts the next value into |value|, returns false when there are no
+  // more values.
+  virtual bool Advance(v8::Isolate* isolate, v8::Local<v8::Value>* value) = 0;
+
+  // Releases the source of the values, called once the iterator is done.
+  virtual void Finish() = 0;
+
+  // Wrappable:
+  ObjectTemplateBuilder GetObjectTemplateBuilder(
+      v8::Isolate* isolate) override;
+
+ private:
+  v8::Local<v8::Object> Next(v8::Isolate* isolate);
+  v8::Local<v8::Object> Return(v8::Isolate* isolate);
+  v8::Local<v8::Object> GetIterator(v8::Isolate* isolate);
+
+  v8::Local<v8::Object> Done(v8::Isolate* isolate);
+
+  bool done_;
+
+  DISALLOW_COPY_AND_ASSIGN(IteratorBase);
+};
+
+// Releases the element of |range| at |*it| once it has been converted and
+// moves |*it| to the next one. The element is moved out and destroyed, which
+// frees what it owns without shifting the elements after it, and its slot is
+// released with the range when the iteration ends.
+template<typename Range, typename Enable = void>
+struct RangeRelease {
+  static void Release(Range* range, typename Range::iterator* it) {
+    typename Range::value_type consumed(std::move(**it));
+    ++*it;
+  }
+};
+
+// Const elements, as in sets, can't be moved out and are kept until the
+// iteration ends.
+template<typename Range>
+struct RangeRelease<Range, typename enable_if<std::is_const<
+    typename std::remove_reference<typename std::iterator_traits<
+        typename Range::iterator>::reference>::type>::value>::type> {
+  static void Release(Range* range, typename Range::iterator* it) {
+    ++*it;
+  }
+};
+
+// Deques and lists erase their first element, slot included.
+template<typename Range>
+struct PopFrontRangeRelease {
+  static void Release(Range* range, typename Range::iterator* it) {
+    range->pop_front();
+    *it = range->begin();
+  }
+};
+
+template<typename T, typename A>
+struct RangeRelease<std::deque<T, A> >
+    : public PopFrontRangeRelease<std::deque<T, A> > {};
+
+template<typename T, typename A>
+struct RangeRelease<std::list<T, A> >
+    : public PopFrontRangeRelease<std::list<T, A> > {};
+
+template<typename Range>
+class RangeIterator : public IteratorBase {
+ public:
+  explicit RangeIterator(Range range)
+      : range_(std::move(range)), next_(range_.begin()) {}
+
+ protected:
+  bool Advance(v8::Isolate* isolate, v8::Local<v8::Value>* value) override {
+    if (next_ == range_.end())
+      return false;
+    *value = ConvertToV8<typename Range::value_type>(isolate, *next_);
+    RangeRelease<Range>::Release(&range_, &next_);
+    return true;
+  }
+
+  void Finish() override {
+    range_ = Range();
+    next_ = range_.begin();
+  }
+
+ private:
+  Range range_;
+  typename Range::iterator next_;
+
+  DISALLOW_COPY_AND_ASSIGN(RangeIterator);
+};
+
+template<typename T>
+class GeneratorIterator : public IteratorBase {
+ public:
+  explicit GeneratorIterator(const base::Callback<bool(T*)>& generator)
+      : generator_(generator) {}
+
+ protected:
+  bool Advance(v8::Isolate* isolate, v8::Local<v8::Value>* value) override {
+    T element;
+    if (!generator_.Run(&element))
+      return false;
+    *value = ConvertToV8(isolate, element);
+    return true;
+  }
+
+  void Finish() override {
+    generator_.Reset();
+  }
+
+ private:
+  base::Callback<bool(T*)> generator_;
+
+  DISALLOW_COPY_AND_ASSIGN(GeneratorIterator);
+};
+
+}  // namespace internal
+
+// Returns a JavaScript iterator over |range|, which converts the elements
+// with Converter<T>::ToV8 as they are requested instead of creating an array
+// of all of them:
+//
+//   std::vector<Row> rows = cursor->FetchAll();
+//   return mate::CreateIterator(isolate, std::move(rows));
+//
+//   for (const row of db.query(sql)) { if (found(row)) break; }
+//
+// The iterator keeps |range| as it is and walks it in place. Each element is
+// destroyed once it is converted, deques and lists also erase it, and the
+// rest of the range is released when the iteration ends or is stopped with
+// return(), as a break in for-of does.
+template<typename Range>
+v8::Local<v8::Object> CreateIterator(v8::Isolate* isolate, Range range) {
+  return (new internal::RangeIterator<Range>(std::move(range)))
+      ->GetWrapper(isolate);
+}
+
+// Returns a JavaScript iterator over the values of |generator|, which is run
+// for each value and returns false when there are no more.
+template<typename T>
+v8::Local<v8::Object> CreateIterator(
+    v8::Isolate* isolate, const base::Callback<bool(T*)>& generator) {
+  return (new internal::GeneratorIterator<T>(generator))->GetWrapper(isolate);
+}
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_ITERATOR_H_
@@ -0,0 +1,33 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/key_set.h"
+
+#include "native_mate/converter.h"
+#include "native_mate/per_isolate_data.h"
+
+namespace mate {
+
+v8::Local<v8::String> KeySet::Get(v8::Isolate* isolate, size_t index) const {
+  return GetKeyList(isolate)[index].Get(isolate);
+}
+
+void KeySet::GetAll(v8::Isolate* isolate, v8::Local<v8::String>* out) const {
+  const PerIsolateData::KeyList& list = GetKeyList(isolate);
+  for (size_t i = 0; i < size_; ++i)
+    out[i] = list[i].Get(isolate);
+}
+
+const PerIsolateData::KeyList& KeySet::GetKeyList(v8::Isolate* isolate) const {
+  PerIsolateData::KeyList* list =
+      PerIsolateData::From(isolate)->GetKeyList(this);
+  if (list->empty()) {
+    list->resize(size_);
+    for (size_t i = 0; i < size_; ++i)
+      (*list)[i].Set(isolate, StringToSymbol(isolate, name(i)));
+  }
+  return *list;
+}
+
+}  // namespace mate
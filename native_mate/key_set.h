@@ -0,0 +1,64 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_KEY_SET_H_
+#define NATIVE_MATE_KEY_SET_H_
+
+#include <stddef.h>
+
+#include "base/basictypes.h"
+#include "native_mate/per_isolate_data.h"
+#include "v8/include/v8.h"
+
+namespace mate {
+
+// KeySet is a fixed list of property names. The internalized V8 strings of
+// the names are created once per isolate and reused afterwards, so code that
+// accesses the same properties over and over does not pay for creating and
+// hashing a new key string on every access.
+//
+// The address of a KeySet is used to look up its cached keys, so KeySets must
+// have static storage duration:
+//
+//   static const char* const kOptionNames[] = { "width", "height" };
+//   static const mate::KeySet kOptionKeys(kOptionNames);
+//
+// Generated code that has no array of names can provide them through a
+// NameGetter instead, it is only called when the keys are created.
+class KeySet {
+ public:
+  typedef const char* (*NameGetter)(size_t index);
+
+  template<size_t N>
+  constexpr explicit KeySet(const char* const (&names)[N])
+      : names_(names), name_getter_(NULL), size_(N) {}
+  constexpr KeySet(NameGetter name_getter, size_t size)
+      : names_(NULL), name_getter_(name_getter), size_(size) {}
+
+  size_t size() const { return size_; }
+  const char* name(size_t index) const {
+    return names_ ? names_[index] : name_getter_(index);
+  }
+
+  // Returns the internalized key at |index|.
+  v8::Local<v8::String> Get(v8::Isolate* isolate, size_t index) const;
+
+  // Writes all internalized keys to |out|, which must have room for size()
+  // handles.
+  void GetAll(v8::Isolate* isolate, v8::Local<v8::String>* out) const;
+
+  // Returns the cached keys of |isolate|, creating them on first use.
+  const PerIsolateData::KeyList& GetKeyList(v8::Isolate* isolate) const;
+
+ private:
+  const char* const* names_;
+  NameGetter name_getter_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(KeySet);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_KEY_SET_H_
@@ -0,0 +1,154 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/mapped_file.h"
+
+#include "build/build_config.h"
+
+#if defined(OS_WIN)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/posix/eintr_wrapper.h"
+#endif
+
+namespace mate {
+
+#if defined(OS_WIN)
+
+// static
+scoped_refptr<MappedFile> MappedFile::Open(const std::string& path) {
+  int size = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, NULL, 0);
+  if (size <= 0)
+    return NULL;
+  std::wstring wide_path(size, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wide_path[0], size);
+
+  HANDLE file = CreateFileW(wide_path.c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE |
+                                FILE_SHARE_DELETE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      static_cast<uint64_t>(file_size.QuadPart) >
+          static_cast<uint64_t>(kWholeFile)) {
+    CloseHandle(file);
+    return NULL;
+  }
+  size_t length = static_cast<size_t>(file_size.QuadPart);
+  if (length == 0) {
+    CloseHandle(file);
+    return new MappedFile(NULL, 0);
+  }
+
+  // The view keeps the file open, the handles are not needed after mapping.
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if (!mapping)
+    return NULL;
+  void* data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, length);
+  CloseHandle(mapping);
+  if (!data)
+    return NULL;
+  return new MappedFile(static_cast<uint8_t*>(data), length);
+}
+
+bool MappedFile::Advise(Access access, size_t offset, size_t length) {
+  return false;
+}
+
+MappedFile::~MappedFile() {
+  if (data_)
+    UnmapViewOfFile(data_);
+}
+
+#else  // defined(OS_WIN)
+
+// static
+scoped_refptr<MappedFile> MappedFile::Open(const std::string& path) {
+  int fd = HANDLE_EINTR(open(path.c_str(), O_RDONLY));
+  if (fd < 0)
+    return NULL;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 ||
+      static_cast<uint64_t>(info.st_size) >
+          static_cast<uint64_t>(kWholeFile)) {
+    close(fd);
+    return NULL;
+  }
+  size_t length = static_cast<size_t>(info.st_size);
+  if (length == 0) {
+    close(fd);
+    return new MappedFile(NULL, 0);
+  }
+
+  // The mapping keeps the file open, the descriptor is not needed after it.
+  void* data = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    return NULL;
+  return new MappedFile(static_cast<uint8_t*>(data), length);
+}
+
+bool MappedFile::Advise(Access access, size_t offset, size_t length) {
+  if (offset >= length_)
+    return false;
+  if (length > length_ - offset)
+    length = length_ - offset;
+
+  // madvise needs a page aligned address.
+  size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t aligned_offset = offset - offset % page_size;
+  length += offset - aligned_offset;
+
+  int advice = MADV_NORMAL;
+  switch (access) {
+    case NORMAL: advice = MADV_NORMAL; break;
+    case SEQUENTIAL: advice = MADV_SEQUENTIAL; break;
+    case RANDOM: advice = MADV_RANDOM; break;
+    case WILL_NEED: advice = MADV_WILLNEED; break;
+    case DONT_NEED: advice = MADV_DONTNEED; break;
+  }
+  return madvise(data_ + aligned_offset, length, advice) == 0;
+}
+
+MappedFile::~MappedFile() {
+  if (data_)
+    munmap(data_, length_);
+}
+
+#endif  // defined(OS_WIN)
+
+scoped_refptr<BackingStore> MappedFile::Slice(size_t offset, size_t length) {
+  if (offset > length_ || length > length_ - offset)
+    return NULL;
+  AddRef();
+  return BackingStore::WrapMapped(data_ + offset, length, &ReleaseSlice, this);
+}
+
+MappedFile::MappedFile(uint8_t* data, size_t length)
+    : data_(data), length_(length) {
+}
+
+// static
+void MappedFile::ReleaseSlice(void* data, size_t length, void* deleter_data) {
+  static_cast<MappedFile*>(deleter_data)->Release();
+}
+
+v8::Local<v8::Value> Converter<scoped_refptr<MappedFile> >::ToV8(
+    v8::Isolate* isolate, const scoped_refptr<MappedFile>& val) {
+  if (!val)
+    return v8::Null(isolate);
+  return ConvertToV8(isolate, val->Slice(0, val->length()));
+}
+
+}  // namespace mate
@@ -0,0 +1,83 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_MAPPED_FILE_H_
+#define NATIVE_MATE_MAPPED_FILE_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "base/memory/ref_counted.h"
+#include "native_mate/backing_store.h"
+#include "native_mate/converter.h"
+
+namespace mate {
+
+// MappedFile maps a whole file into memory, and hands windows of it to
+// JavaScript as ArrayBuffers without copying:
+//
+//   scoped_refptr<mate::MappedFile> file = mate::MappedFile::Open(path);
+//   if (!file)
+//     return v8::Null(isolate);
+//   file->Advise(mate::MappedFile::SEQUENTIAL);
+//   return mate::ConvertToV8(isolate, file->Slice(offset, length));
+//
+// Pages are read on demand, so scanning a file only keeps the pages being
+// read resident. The mapping is private and copy-on-write: writes from
+// JavaScript change the process's copy of the page and never the file. The
+// file is unmapped when the last MappedFile and slice reference is dropped,
+// including the ArrayBuffers that are still alive.
+class MappedFile : public base::RefCountedThreadSafe<MappedFile> {
+ public:
+  // Access pattern hints for Advise(). DONT_NEED drops the pages from memory,
+  // along with the changes made to them.
+  enum Access {
+    NORMAL,
+    SEQUENTIAL,
+    RANDOM,
+    WILL_NEED,
+    DONT_NEED,
+  };
+
+  // Maps the file at |path|, in UTF-8. Returns NULL on failure.
+  static scoped_refptr<MappedFile> Open(const std::string& path);
+
+  // Returns a store for |length| bytes from |offset|, which keeps the file
+  // mapped. Returns NULL if the range is out of the file.
+  scoped_refptr<BackingStore> Slice(size_t offset, size_t length);
+
+  // Tells the system how the range will be accessed, the whole file by
+  // default. Returns false if the hint is not supported.
+  bool Advise(Access access, size_t offset = 0, size_t length = kWholeFile);
+
+  const uint8_t* data() const { return data_; }
+  size_t length() const { return length_; }
+
+  static const size_t kWholeFile = static_cast<size_t>(-1);
+
+ private:
+  friend class base::RefCountedThreadSafe<MappedFile>;
+
+  MappedFile(uint8_t* data, size_t length);
+  ~MappedFile();
+
+  static void ReleaseSlice(void* data, size_t length, void* deleter_data);
+
+  uint8_t* data_;
+  size_t length_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+};
+
+// Converts the whole file to an ArrayBuffer.
+template<>
+struct Converter<scoped_refptr<MappedFile> > {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const scoped_refptr<MappedFile>& val);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_MAPPED_FILE_H_
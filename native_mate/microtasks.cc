@@ -0,0 +1,16 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/microtasks.h"
+
+namespace mate {
+
+void RunMicrotasks(v8::Isolate* isolate) {
+  if (isolate->GetMicrotasksPolicy() == v8::MicrotasksPolicy::kScoped)
+    v8::MicrotasksScope::PerformCheckpoint(isolate);
+  else
+    isolate->RunMicrotasks();
+}
+
+}  // namespace mate
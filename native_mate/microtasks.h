@@ -0,0 +1,18 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_MICROTASKS_H_
+#define NATIVE_MATE_MICROTASKS_H_
+
+#include "v8/include/v8.h"
+
+namespace mate {
+
+// Runs the pending microtasks, like the reactions of promises resolved from
+// a posted task, whichever microtasks policy the embedder uses.
+void RunMicrotasks(v8::Isolate* isolate);
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_MICROTASKS_H_
@@ -4,13 +4,15 @@
 
 #include "native_mate/object_template_builder.h"
 
+#include "native_mate/wrappable.h"
+
 namespace mate {
 
 ObjectTemplateBuilder::ObjectTemplateBuilder(
     v8::Isolate* isolate,
     v8::Local<v8::ObjectTemplate> templ)
     : isolate_(isolate), template_(templ) {
-  template_->SetInternalFieldCount(1);
+  internal::SetUpWrapperTemplate(isolate_, template_);
 }
 
 ObjectTemplateBuilder::~ObjectTemplateBuilder() {
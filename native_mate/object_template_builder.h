@@ -8,6 +8,7 @@
 #include "base/bind.h"
 #include "base/callback.h"
 #include "base/strings/string_piece.h"
+#include "native_mate/binding_stats.h"
 #include "native_mate/converter.h"
 #include "native_mate/function_template.h"
 #include "native_mate/template_util.h"
@@ -59,7 +60,8 @@ struct CallbackTraits<T, typename enable_if<
 template<>
 struct CallbackTraits<v8::Local<v8::FunctionTemplate> > {
   static v8::Local<v8::FunctionTemplate> CreateTemplate(
-      v8::Local<v8::FunctionTemplate> templ) {
+      v8::Isolate* isolate, v8::Local<v8::FunctionTemplate> templ,
+      bool = true) {
     return templ;
   }
 };
@@ -92,6 +94,7 @@ class ObjectTemplateBuilder {
   ObjectTemplateBuilder& SetMethod(const base::StringPiece& name,
                                    T callback,
                                    bool safe_after_destroyed = false) {
+    MATE_BINDING_STATS_SCOPE(isolate_, "", name);
     return SetImpl(name,
                    CallbackTraits<T>::CreateTemplate(isolate_,
                                                      callback,
@@ -101,6 +104,7 @@ class ObjectTemplateBuilder {
   ObjectTemplateBuilder& SetProperty(const base::StringPiece& name,
                                      T getter,
                                      bool safe_after_destroyed = false) {
+    MATE_BINDING_STATS_SCOPE(isolate_, "get ", name);
     return SetPropertyImpl(
         name,
         CallbackTraits<T>::CreateTemplate(isolate_, getter,
@@ -112,10 +116,16 @@ class ObjectTemplateBuilder {
                                      T getter,
                                      U setter,
                                      bool safe_after_destroyed = false) {
+    v8::Local<v8::FunctionTemplate> getter_template;
+    {
+      MATE_BINDING_STATS_SCOPE(isolate_, "get ", name);
+      getter_template = CallbackTraits<T>::CreateTemplate(
+          isolate_, getter, safe_after_destroyed);
+    }
+    MATE_BINDING_STATS_SCOPE(isolate_, "set ", name);
     return SetPropertyImpl(
         name,
-        CallbackTraits<T>::CreateTemplate(isolate_, getter,
-                                          safe_after_destroyed),
+        getter_template,
         CallbackTraits<U>::CreateTemplate(isolate_, setter,
                                           safe_after_destroyed));
   }
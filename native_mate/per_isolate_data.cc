@@ -0,0 +1,99 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/per_isolate_data.h"
+
+#include "base/logging.h"
+#include "native_mate/converter.h"
+#include "native_mate/private_key.h"
+#include "native_mate/string_cache.h"
+
+namespace mate {
+
+PerIsolateData::PerIsolateData(v8::Isolate* isolate)
+    : isolate_(isolate),
+      array_buffer_allocator_(NULL),
+      string_cache_(NULL) {
+}
+
+PerIsolateData::~PerIsolateData() {
+  delete string_cache_;
+}
+
+// static
+PerIsolateData* PerIsolateData::From(v8::Isolate* isolate) {
+  PerIsolateData* data =
+      static_cast<PerIsolateData*>(isolate->GetData(MATE_ISOLATE_DATA_SLOT));
+  if (!data) {
+    CHECK_LT(static_cast<uint32_t>(MATE_ISOLATE_DATA_SLOT),
+             v8::Isolate::GetNumberOfDataSlots());
+    data = new PerIsolateData(isolate);
+    isolate->SetData(MATE_ISOLATE_DATA_SLOT, data);
+  }
+  return data;
+}
+
+void PerIsolateData::set_string_cache(StringCache* cache) {
+  delete string_cache_;
+  string_cache_ = cache;
+}
+
+v8::Local<v8::ObjectTemplate> PerIsolateData::GetObjectTemplate(
+    const void* key) {
+  std::map<const void*, v8::Eternal<v8::ObjectTemplate> >::iterator it =
+      object_templates_.find(key);
+  if (it == object_templates_.end())
+    return v8::Local<v8::ObjectTemplate>();
+  return it->second.Get(isolate_);
+}
+
+void PerIsolateData::SetObjectTemplate(const void* key,
+                                       v8::Local<v8::ObjectTemplate> templ) {
+  object_templates_[key].Set(isolate_, templ);
+}
+
+v8::Local<v8::FunctionTemplate> PerIsolateData::GetFunctionTemplate(
+    const void* key) {
+  std::map<const void*, v8::Eternal<v8::FunctionTemplate> >::iterator it =
+      function_templates_.find(key);
+  if (it == function_templates_.end())
+    return v8::Local<v8::FunctionTemplate>();
+  return it->second.Get(isolate_);
+}
+
+void PerIsolateData::SetFunctionTemplate(
+    const void* key, v8::Local<v8::FunctionTemplate> templ) {
+  function_templates_[key].Set(isolate_, templ);
+}
+
+v8::Local<v8::Private> PerIsolateData::GetPrivateKey(
+    const base::StringPiece& name) {
+  v8::Eternal<v8::Private>& key = private_keys_[name.as_string()];
+  if (key.IsEmpty())
+    key.Set(isolate_, v8::Private::ForApi(isolate_,
+                                          StringToSymbol(isolate_, name)));
+  return key.Get(isolate_);
+}
+
+v8::Local<v8::Private> PerIsolateData::GetPrivateKey(const PrivateKey& key) {
+  size_t index = key.index();
+  if (index >= private_key_table_.size())
+    private_key_table_.resize(index + 1);
+  v8::Eternal<v8::Private>& private_key = private_key_table_[index];
+  if (private_key.IsEmpty())
+    private_key.Set(isolate_, GetPrivateKey(key.name()));
+  return private_key.Get(isolate_);
+}
+
+// static
+void PerIsolateData::Dispose(v8::Isolate* isolate) {
+  PerIsolateData* data =
+      static_cast<PerIsolateData*>(isolate->GetData(MATE_ISOLATE_DATA_SLOT));
+  if (!data)
+    return;
+  isolate->SetData(MATE_ISOLATE_DATA_SLOT, NULL);
+  delete data;
+}
+
+}  // namespace mate
@@ -0,0 +1,99 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_PER_ISOLATE_DATA_H_
+#define NATIVE_MATE_PER_ISOLATE_DATA_H_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/strings/string_piece.h"
+#include "v8/include/v8.h"
+
+// The isolate data slot PerIsolateData is stored in. gin and Blink use the
+// first slots, embedders that use this one for something else can move it.
+#ifndef MATE_ISOLATE_DATA_SLOT
+#define MATE_ISOLATE_DATA_SLOT 3
+#endif
+
+namespace mate {
+
+class KeySet;
+class PrivateKey;
+class StringCache;
+
+// PerIsolateData stores the handles native_mate caches for an isolate, like
+// the internalized property names of a KeySet, the ObjectTemplate of a
+// RecordTemplate or the private symbols used for hidden values.
+//
+// The data is created the first time it is requested for an isolate and is
+// kept until Dispose is called, embedders should call Dispose before
+// disposing the isolate. It lives in an isolate data slot, so looking it up
+// takes no lock; like the isolate, it must only be used by the thread that
+// has entered the isolate.
+class PerIsolateData {
+ public:
+  typedef std::vector<v8::Eternal<v8::String> > KeyList;
+
+  static PerIsolateData* From(v8::Isolate* isolate);
+  static void Dispose(v8::Isolate* isolate);
+
+  // Returns the cached keys of |keys|, the list is empty if they have not
+  // been created in this isolate yet.
+  KeyList* GetKeyList(const KeySet* keys) { return &key_lists_[keys]; }
+
+  // Object templates cached by the address of a static object that owns
+  // them, GetObjectTemplate returns an empty handle on a miss.
+  v8::Local<v8::ObjectTemplate> GetObjectTemplate(const void* key);
+  void SetObjectTemplate(const void* key,
+                         v8::Local<v8::ObjectTemplate> templ);
+
+  // Function templates cached the same way.
+  v8::Local<v8::FunctionTemplate> GetFunctionTemplate(const void* key);
+  void SetFunctionTemplate(const void* key,
+                           v8::Local<v8::FunctionTemplate> templ);
+
+  // Returns the private symbol for |name|, it is the same symbol that
+  // v8::Private::ForApi returns but does not need a new string to look it up.
+  v8::Local<v8::Private> GetPrivateKey(const base::StringPiece& name);
+  // Same, without the lookup by name.
+  v8::Local<v8::Private> GetPrivateKey(const PrivateKey& key);
+
+  // The allocator the isolate was created with, embedders that want native
+  // code to take over JavaScript created buffers must set it.
+  void set_array_buffer_allocator(v8::ArrayBuffer::Allocator* allocator) {
+    array_buffer_allocator_ = allocator;
+  }
+  v8::ArrayBuffer::Allocator* array_buffer_allocator() const {
+    return array_buffer_allocator_;
+  }
+
+  // The StringCache of the isolate, owned by the data once set.
+  void set_string_cache(StringCache* cache);
+  StringCache* string_cache() const { return string_cache_; }
+
+  v8::Isolate* isolate() const { return isolate_; }
+
+ private:
+  explicit PerIsolateData(v8::Isolate* isolate);
+  ~PerIsolateData();
+
+  v8::Isolate* isolate_;
+  v8::ArrayBuffer::Allocator* array_buffer_allocator_;
+  StringCache* string_cache_;
+  std::map<const KeySet*, KeyList> key_lists_;
+  std::map<const void*, v8::Eternal<v8::ObjectTemplate> > object_templates_;
+  std::map<const void*, v8::Eternal<v8::FunctionTemplate> >
+      function_templates_;
+  std::map<std::string, v8::Eternal<v8::Private> > private_keys_;
+  std::vector<v8::Eternal<v8::Private> > private_key_table_;
+
+  DISALLOW_COPY_AND_ASSIGN(PerIsolateData);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_PER_ISOLATE_DATA_H_
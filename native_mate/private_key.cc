@@ -0,0 +1,33 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/private_key.h"
+
+#include "native_mate/per_isolate_data.h"
+
+namespace mate {
+
+namespace {
+
+std::atomic<int> g_next_index(0);
+
+}  // namespace
+
+v8::Local<v8::Private> PrivateKey::Get(v8::Isolate* isolate) const {
+  return PerIsolateData::From(isolate)->GetPrivateKey(*this);
+}
+
+size_t PrivateKey::index() const {
+  int index = index_.load(std::memory_order_acquire);
+  if (index < 0) {
+    // Threads that race here all agree on the first index stored.
+    int new_index = g_next_index.fetch_add(1, std::memory_order_relaxed);
+    if (index_.compare_exchange_strong(index, new_index,
+                                       std::memory_order_acq_rel))
+      index = new_index;
+  }
+  return static_cast<size_t>(index);
+}
+
+}  // namespace mate
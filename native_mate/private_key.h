@@ -0,0 +1,48 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_PRIVATE_KEY_H_
+#define NATIVE_MATE_PRIVATE_KEY_H_
+
+#include <stddef.h>
+
+#include <atomic>
+
+#include "base/basictypes.h"
+#include "v8/include/v8.h"
+
+namespace mate {
+
+// PrivateKey names a private symbol for hidden values. Looking it up is an
+// index into a per-isolate table, without the string copy and map lookup of
+// looking a private symbol up by name, so code that reads a hidden value on
+// every call keeps one:
+//
+//   static const mate::PrivateKey kOwnerKey("owner");
+//   dict.GetHidden(kOwnerKey, &owner);
+//
+// The symbol is the one v8::Private::ForApi returns for the name. PrivateKeys
+// must have static storage duration.
+class PrivateKey {
+ public:
+  constexpr explicit PrivateKey(const char* name) : name_(name), index_(-1) {}
+
+  const char* name() const { return name_; }
+
+  // Returns the private symbol in |isolate|, creating it on first use.
+  v8::Local<v8::Private> Get(v8::Isolate* isolate) const;
+
+  // The index of the key in the per-isolate table, assigned on first use.
+  size_t index() const;
+
+ private:
+  const char* name_;
+  mutable std::atomic<int> index_;
+
+  DISALLOW_COPY_AND_ASSIGN(PrivateKey);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_PRIVATE_KEY_H_
@@ -0,0 +1,43 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/record_template.h"
+
+#include "native_mate/per_isolate_data.h"
+
+namespace mate {
+
+v8::Local<v8::Object> RecordTemplate::NewInstance(v8::Isolate* isolate) const {
+  PerIsolateData* data = PerIsolateData::From(isolate);
+  v8::Local<v8::ObjectTemplate> templ = data->GetObjectTemplate(this);
+  if (templ.IsEmpty()) {
+    const PerIsolateData::KeyList& keys = keys_.GetKeyList(isolate);
+    templ = v8::ObjectTemplate::New(isolate);
+    for (size_t i = 0; i < keys.size(); ++i)
+      templ->Set(keys[i].Get(isolate), MATE_UNDEFINED(isolate));
+    data->SetObjectTemplate(this, templ);
+  }
+
+  v8::Local<v8::Object> object;
+  if (!templ->NewInstance(isolate->GetCurrentContext()).ToLocal(&object))
+    return v8::Local<v8::Object>();
+  return object;
+}
+
+v8::Local<v8::Object> RecordTemplate::NewWithValues(
+    v8::Isolate* isolate, const v8::Local<v8::Value>* values) const {
+  v8::Local<v8::Object> object = NewInstance(isolate);
+  if (object.IsEmpty())
+    return object;
+  const PerIsolateData::KeyList& keys = keys_.GetKeyList(isolate);
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (!object->CreateDataProperty(context, keys[i].Get(isolate), values[i])
+             .FromMaybe(false))
+      return v8::Local<v8::Object>();
+  }
+  return object;
+}
+
+}  // namespace mate
@@ -0,0 +1,60 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_RECORD_TEMPLATE_H_
+#define NATIVE_MATE_RECORD_TEMPLATE_H_
+
+#include "base/logging.h"
+#include "native_mate/converter.h"
+#include "native_mate/key_set.h"
+
+namespace mate {
+
+// RecordTemplate creates objects with a fixed list of properties, which are
+// all declared upfront by an ObjectTemplate. Objects created by the same
+// RecordTemplate share one hidden class from the start, instead of moving
+// through a new hidden class for every property set on an empty object, and
+// property accesses on them stay monomorphic in JavaScript.
+//
+// Like KeySets, RecordTemplates must have static storage duration:
+//
+//   static const char* const kRowNames[] = { "id", "name" };
+//   static const mate::KeySet kRowKeys(kRowNames);
+//   static const mate::RecordTemplate kRowTemplate(kRowKeys);
+//
+//   v8::Local<v8::Object> row = kRowTemplate.New(isolate, id, name);
+class RecordTemplate {
+ public:
+  constexpr explicit RecordTemplate(const KeySet& keys) : keys_(keys) {}
+
+  const KeySet& keys() const { return keys_; }
+
+  // Creates an object whose fields are all undefined, returns an empty
+  // handle if the object could not be created.
+  v8::Local<v8::Object> NewInstance(v8::Isolate* isolate) const;
+
+  // Creates an object with |vals| as the values of the fields, in the order
+  // of the keys, returns an empty handle on failure.
+  template<typename... Ts>
+  v8::Local<v8::Object> New(v8::Isolate* isolate, const Ts&... vals) const {
+    static_assert(sizeof...(Ts) > 0, "RecordTemplate::New needs values");
+    CHECK_EQ(keys_.size(), sizeof...(Ts));
+    v8::Local<v8::Value> values[] = { ConvertToV8(isolate, vals)... };
+    return NewWithValues(isolate, values);
+  }
+
+  // Like New, but takes the already converted values, |values| must hold
+  // one handle for each key.
+  v8::Local<v8::Object> NewWithValues(
+      v8::Isolate* isolate, const v8::Local<v8::Value>* values) const;
+
+ private:
+  const KeySet& keys_;
+
+  DISALLOW_COPY_AND_ASSIGN(RecordTemplate);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_RECORD_TEMPLATE_H_
@@ -0,0 +1,90 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/shaped_array.h"
+
+namespace mate {
+
+namespace internal {
+
+namespace {
+
+const char* const kShapedArrayNames[] = { "shape", "data" };
+const KeySet kShapedArrayKeys(kShapedArrayNames);
+const RecordTemplate kShapedArrayTemplate(kShapedArrayKeys);
+
+}  // namespace
+
+const KeySet& GetShapedArrayKeys() {
+  return kShapedArrayKeys;
+}
+
+const RecordTemplate& GetShapedArrayTemplate() {
+  return kShapedArrayTemplate;
+}
+
+bool GetElementCount(const std::vector<size_t>& shape, size_t* count) {
+  size_t result = 1;
+  for (size_t i = 0; i < shape.size(); ++i) {
+    if (shape[i] == 0) {
+      *count = 0;
+      return true;
+    }
+    if (shape[i] > v8::TypedArray::kMaxLength / result)
+      return false;
+    result *= shape[i];
+  }
+  *count = result;
+  return true;
+}
+
+std::vector<size_t> GetStrides(const std::vector<size_t>& shape) {
+  std::vector<size_t> strides(shape.size());
+  size_t stride = 1;
+  for (size_t i = shape.size(); i > 0; --i) {
+    strides[i - 1] = stride;
+    stride *= shape[i - 1];
+  }
+  return strides;
+}
+
+v8::Local<v8::Value> ShapeToV8(v8::Isolate* isolate,
+                               const std::vector<size_t>& shape) {
+  v8::Local<v8::Array> result(
+      MATE_ARRAY_NEW(isolate, static_cast<int>(shape.size())));
+  for (size_t i = 0; i < shape.size(); ++i)
+    result->Set(static_cast<uint32_t>(i),
+                MATE_NUMBER_NEW(isolate, static_cast<double>(shape[i])));
+  return result;
+}
+
+bool ShapeFromV8(v8::Isolate* isolate,
+                 v8::Local<v8::Value> val,
+                 std::vector<size_t>* shape) {
+  std::vector<uint32_t> dimensions;
+  if (!ConvertFromV8(isolate, val, &dimensions))
+    return false;
+  shape->assign(dimensions.begin(), dimensions.end());
+  return true;
+}
+
+bool GetNestedShape(v8::Local<v8::Context> context,
+                    v8::Local<v8::Array> array,
+                    std::vector<size_t>* shape) {
+  shape->clear();
+  v8::Local<v8::Value> val = array;
+  while (val->IsArray()) {
+    array = v8::Local<v8::Array>::Cast(val);
+    shape->push_back(array->Length());
+    if (array->Length() == 0)
+      break;
+    if (!array->Get(context, 0).ToLocal(&val))
+      return false;
+  }
+  return true;
+}
+
+}  // namespace internal
+
+}  // namespace mate
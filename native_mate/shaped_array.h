@@ -0,0 +1,260 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_SHAPED_ARRAY_H_
+#define NATIVE_MATE_SHAPED_ARRAY_H_
+
+#include <string.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "base/logging.h"
+#include "native_mate/converter.h"
+#include "native_mate/record_template.h"
+#include "native_mate/typed_array_traits.h"
+
+namespace mate {
+
+namespace internal {
+
+// Keys of the { shape, data } object.
+const KeySet& GetShapedArrayKeys();
+const RecordTemplate& GetShapedArrayTemplate();
+
+// Computes the number of elements of |shape|, returns false when it is more
+// than a typed array can hold.
+bool GetElementCount(const std::vector<size_t>& shape, size_t* count);
+
+// Returns the row-major strides of |shape|, in elements.
+std::vector<size_t> GetStrides(const std::vector<size_t>& shape);
+
+v8::Local<v8::Value> ShapeToV8(v8::Isolate* isolate,
+                               const std::vector<size_t>& shape);
+bool ShapeFromV8(v8::Isolate* isolate,
+                 v8::Local<v8::Value> val,
+                 std::vector<size_t>* shape);
+
+// Reads the shape of nested arrays from their first elements.
+bool GetNestedShape(v8::Local<v8::Context> context,
+                    v8::Local<v8::Array> array,
+                    std::vector<size_t>* shape);
+
+}  // namespace internal
+
+// ShapedArray is an n-dimensional array of numbers stored in one flat buffer
+// in row-major order, with the |shape| of the dimensions and the |strides|,
+// in elements, to step along each of them. It converts to
+//
+//   { shape: [rows, columns], data: Float64Array }
+//
+// so a matrix costs one typed array instead of an array per row and a boxed
+// number per element. FromV8 accepts the same form, with a plain array also
+// allowed for |data|, or nested arrays such as [[1, 2], [3, 4]], which must
+// not be ragged and are flattened into one allocation.
+//
+// T must be one of the types of TypedArrayTraits.
+template<typename T>
+class ShapedArray {
+ public:
+  ShapedArray() {}
+
+  // Creates an array of |shape| with value-initialized elements.
+  explicit ShapedArray(std::vector<size_t> shape)
+      : shape_(std::move(shape)), strides_(internal::GetStrides(shape_)) {
+    data_.resize(CountElements(shape_));
+  }
+
+  // Creates an array of |shape| holding |data|, which must have as many
+  // elements as the shape.
+  ShapedArray(std::vector<size_t> shape, std::vector<T> data)
+      : shape_(std::move(shape)),
+        strides_(internal::GetStrides(shape_)),
+        data_(std::move(data)) {
+    DCHECK_EQ(CountElements(shape_), data_.size());
+  }
+
+  // Creates a two-dimensional array from |rows|, which must all have the
+  // same length.
+  static ShapedArray FromRows(const std::vector<std::vector<T> >& rows) {
+    std::vector<size_t> shape(2);
+    shape[0] = rows.size();
+    shape[1] = rows.empty() ? 0 : rows[0].size();
+    ShapedArray result(std::move(shape));
+    T* data = result.data();
+    for (size_t i = 0; i < rows.size(); ++i) {
+      DCHECK_EQ(result.shape_[1], rows[i].size());
+      std::copy(rows[i].begin(), rows[i].end(), data);
+      data += rows[i].size();
+    }
+    return result;
+  }
+
+  const std::vector<size_t>& shape() const { return shape_; }
+  const std::vector<size_t>& strides() const { return strides_; }
+  size_t rank() const { return shape_.size(); }
+  size_t size() const { return data_.size(); }
+
+  T* data() { return data_.data(); }
+  const T* data() const { return data_.data(); }
+
+  // Returns the element at |index|, which has one position per dimension.
+  T& at(const std::vector<size_t>& index) {
+    return data_[GetOffset(index)];
+  }
+  const T& at(const std::vector<size_t>& index) const {
+    return data_[GetOffset(index)];
+  }
+
+  // Releases the elements.
+  std::vector<T> TakeData() {
+    shape_.clear();
+    strides_.clear();
+    return std::move(data_);
+  }
+
+ private:
+  static size_t CountElements(const std::vector<size_t>& shape) {
+    size_t count = 0;
+    CHECK(internal::GetElementCount(shape, &count));
+    return count;
+  }
+
+  size_t GetOffset(const std::vector<size_t>& index) const {
+    DCHECK_EQ(shape_.size(), index.size());
+    size_t offset = 0;
+    for (size_t i = 0; i < index.size(); ++i) {
+      DCHECK_LT(index[i], shape_[i]);
+      offset += index[i] * strides_[i];
+    }
+    return offset;
+  }
+
+  std::vector<size_t> shape_;
+  std::vector<size_t> strides_;
+  std::vector<T> data_;
+};
+
+namespace internal {
+
+// Copies the leaves of the nested arrays |val| into |*out| and advances it,
+// failing when a dimension does not match |shape|.
+template<typename T>
+bool FlattenNested(v8::Isolate* isolate,
+                   v8::Local<v8::Context> context,
+                   v8::Local<v8::Value> val,
+                   const std::vector<size_t>& shape,
+                   size_t depth,
+                   T** out) {
+  if (!val->IsArray())
+    return false;
+  v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(val);
+  // Getters run by Get may resize the array, so the loop keeps to the length
+  // that was checked against the shape.
+  uint32_t length = array->Length();
+  if (length != shape[depth])
+    return false;
+
+  v8::HandleScope handle_scope(isolate);
+  bool leaves = depth + 1 == shape.size();
+  for (uint32_t i = 0; i < length; ++i) {
+    v8::Local<v8::Value> element;
+    if (!array->Get(context, i).ToLocal(&element))
+      return false;
+    if (leaves) {
+      if (element->IsArray() || !Converter<T>::FromV8(isolate, element, *out))
+        return false;
+      ++*out;
+    } else if (!FlattenNested(isolate, context, element, shape, depth + 1,
+                              out)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace internal
+
+template<typename T>
+struct Converter<ShapedArray<T> > {
+  typedef TypedArrayTraits<T> Traits;
+  static_assert(Traits::kIsSupported,
+                "ShapedArray elements must have a typed array type");
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const ShapedArray<T>& val) {
+    v8::Local<v8::ArrayBuffer> buffer =
+        v8::ArrayBuffer::New(isolate, val.size() * sizeof(T));
+    if (val.size() > 0)
+      memcpy(buffer->GetContents().Data(), val.data(), val.size() * sizeof(T));
+    v8::Local<v8::Value> values[] = {
+      internal::ShapeToV8(isolate, val.shape()),
+      Traits::ArrayType::New(buffer, 0, val.size()),
+    };
+    return internal::GetShapedArrayTemplate().NewWithValues(isolate, values);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     ShapedArray<T>* out) {
+    if (val->IsArray())
+      return FromNested(isolate, v8::Local<v8::Array>::Cast(val), out);
+    if (!val->IsObject())
+      return false;
+
+    const KeySet& keys = internal::GetShapedArrayKeys();
+    v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(val);
+    std::vector<size_t> shape;
+    if (!internal::ShapeFromV8(isolate, object->Get(keys.Get(isolate, 0)),
+                               &shape))
+      return false;
+    size_t count;
+    if (!internal::GetElementCount(shape, &count))
+      return false;
+    v8::Local<v8::Value> data = object->Get(keys.Get(isolate, 1));
+    std::vector<T> values;
+    if (Traits::IsTypedArray(data)) {
+      v8::Local<v8::TypedArray> array = v8::Local<v8::TypedArray>::Cast(data);
+      if (array->Length() != count)
+        return false;
+      const T* begin = GetTypedArrayData<T>(array);
+      values.assign(begin, begin + count);
+    } else if (!ConvertFromV8(isolate, data, &values) ||
+               values.size() != count) {
+      return false;
+    }
+
+    *out = ShapedArray<T>(std::move(shape), std::move(values));
+    return true;
+  }
+
+ private:
+  static bool FromNested(v8::Isolate* isolate,
+                         v8::Local<v8::Array> array,
+                         ShapedArray<T>* out) {
+    v8::Local<v8::Context> context = isolate->GetCurrentContext();
+    std::vector<size_t> shape;
+    if (!internal::GetNestedShape(context, array, &shape))
+      return false;
+    size_t count;
+    if (!internal::GetElementCount(shape, &count))
+      return false;
+
+    // Allocate once for the whole array, then check every dimension while
+    // copying the elements.
+    ShapedArray<T> result(std::move(shape));
+    T* data = result.data();
+    if (!internal::FlattenNested(isolate, context, array, result.shape(), 0,
+                                 &data))
+      return false;
+
+    *out = std::move(result);
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_SHAPED_ARRAY_H_
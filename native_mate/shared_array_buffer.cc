@@ -0,0 +1,98 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/shared_array_buffer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "build/build_config.h"
+#include "native_mate/per_isolate_data.h"
+
+#if defined(OS_WIN)
+#include <malloc.h>
+#endif
+
+namespace mate {
+
+namespace {
+
+void FreeAligned(void* data, size_t length, void* deleter_data) {
+#if defined(OS_WIN)
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+void FreeToAllocator(void* data, size_t length, void* deleter_data) {
+  static_cast<v8::ArrayBuffer::Allocator*>(deleter_data)->Free(data, length);
+}
+
+}  // namespace
+
+scoped_refptr<BackingStore> AllocateSharedMemory(size_t length) {
+  // Aligned allocators may return NULL for zero bytes.
+  size_t size = length > 0 ? length : 1;
+#if defined(OS_WIN)
+  void* data = _aligned_malloc(size, kSharedMemoryAlignment);
+#else
+  void* data = NULL;
+  if (posix_memalign(&data, kSharedMemoryAlignment, size) != 0)
+    data = NULL;
+#endif
+  if (!data)
+    return NULL;
+  memset(data, 0, size);
+  return BackingStore::Wrap(data, length, &FreeAligned, NULL);
+}
+
+v8::Local<v8::Value> Converter<SharedBuffer>::ToV8(v8::Isolate* isolate,
+                                                   const SharedBuffer& val) {
+  if (!val.store)
+    return v8::Null(isolate);
+
+  v8::Local<v8::SharedArrayBuffer> buffer = v8::SharedArrayBuffer::New(
+      isolate, val.store->data(), val.store->length(),
+      v8::ArrayBufferCreationMode::kExternalized);
+  if (!internal::AttachBackingStore(isolate, buffer, val.store))
+    return v8::Local<v8::Value>();
+  return buffer;
+}
+
+bool Converter<SharedBuffer>::FromV8(v8::Isolate* isolate,
+                                     v8::Local<v8::Value> val,
+                                     SharedBuffer* out) {
+  if (!val->IsSharedArrayBuffer())
+    return false;
+  v8::Local<v8::SharedArrayBuffer> buffer =
+      v8::Local<v8::SharedArrayBuffer>::Cast(val);
+  scoped_refptr<BackingStore> store =
+      internal::GetAttachedBackingStore(isolate, buffer);
+  if (store) {
+    out->store = store;
+    return true;
+  }
+
+  // Take over a buffer created by JavaScript. Buffers externalized by others
+  // and reserved memory, like WebAssembly memories, have another owner.
+  v8::ArrayBuffer::Allocator* allocator =
+      PerIsolateData::From(isolate)->array_buffer_allocator();
+  if (!allocator || buffer->IsExternal() ||
+      buffer->GetContents().AllocationMode() !=
+          v8::ArrayBuffer::Allocator::AllocationMode::kNormal)
+    return false;
+  v8::SharedArrayBuffer::Contents contents = buffer->Externalize();
+  store = BackingStore::Wrap(contents.Data(), contents.ByteLength(),
+                             &FreeToAllocator, allocator);
+  if (!internal::AttachBackingStore(isolate, buffer, store)) {
+    // JavaScript still uses the memory, leak it rather than free it.
+    store->AddRef();
+    return false;
+  }
+  out->store = store;
+  return true;
+}
+
+}  // namespace mate
@@ -0,0 +1,109 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_SHARED_ARRAY_BUFFER_H_
+#define NATIVE_MATE_SHARED_ARRAY_BUFFER_H_
+
+#include <stdint.h>
+
+#include "native_mate/backing_store.h"
+
+namespace mate {
+
+// Alignment of the memory returned by AllocateSharedMemory, a cache line, so
+// atomics on any element type are aligned and rings in different buffers do
+// not share lines.
+const size_t kSharedMemoryAlignment = 64;
+
+// Allocates |length| zeroed bytes aligned to kSharedMemoryAlignment, to be
+// shared with JavaScript as a SharedArrayBuffer. Returns NULL on failure.
+scoped_refptr<BackingStore> AllocateSharedMemory(size_t length);
+
+// SharedBuffer is the native side of a SharedArrayBuffer. Native threads
+// keep the memory alive through |store| while JavaScript workers use it:
+//
+//   mate::SharedBuffer ring(mate::AllocateSharedMemory(kRingSize));
+//   worker->PostMessage(mate::ConvertToV8(isolate, ring));
+//   decoder_thread->Start(ring.store);
+//
+// ToV8 creates a SharedArrayBuffer over the store each time. FromV8 accepts
+// the SharedArrayBuffers it created, and SharedArrayBuffers created by
+// JavaScript when the isolate's allocator has been set in PerIsolateData:
+// such a buffer is externalized and its memory freed with the allocator once
+// both sides have released it.
+struct SharedBuffer {
+  SharedBuffer() {}
+  explicit SharedBuffer(scoped_refptr<BackingStore> store) : store(store) {}
+
+  scoped_refptr<BackingStore> store;
+};
+
+// A typed array over a range of a SharedBuffer. |offset| is in bytes and
+// |length| in elements, FromV8 rejects views that are not aligned for T.
+template<typename T>
+struct SharedBufferView {
+  static_assert(TypedArrayTraits<T>::kIsSupported,
+                "SharedBufferView needs a typed array element type");
+  static_assert(kSharedMemoryAlignment % sizeof(T) == 0,
+                "SharedBufferView element is not aligned");
+
+  SharedBufferView() : offset(0), length(0) {}
+  SharedBufferView(scoped_refptr<BackingStore> store,
+                   size_t offset,
+                   size_t length)
+      : store(store), offset(offset), length(length) {}
+
+  T* data() const {
+    return reinterpret_cast<T*>(static_cast<char*>(store->data()) + offset);
+  }
+
+  scoped_refptr<BackingStore> store;
+  size_t offset;
+  size_t length;
+};
+
+template<>
+struct Converter<SharedBuffer> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const SharedBuffer& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     SharedBuffer* out);
+};
+
+template<typename T>
+struct Converter<SharedBufferView<T> > {
+  typedef typename TypedArrayTraits<T>::ArrayType ArrayType;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const SharedBufferView<T>& val) {
+    v8::Local<v8::Value> buffer =
+        ConvertToV8(isolate, SharedBuffer(val.store));
+    if (buffer.IsEmpty() || !buffer->IsSharedArrayBuffer())
+      return buffer;
+    return ArrayType::New(v8::Local<v8::SharedArrayBuffer>::Cast(buffer),
+                          val.offset, val.length);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     SharedBufferView<T>* out) {
+    if (!TypedArrayTraits<T>::IsTypedArray(val))
+      return false;
+    v8::Local<v8::TypedArray> array = v8::Local<v8::TypedArray>::Cast(val);
+    SharedBuffer buffer;
+    if (!ConvertFromV8(isolate, array->Buffer(), &buffer))
+      return false;
+    SharedBufferView<T> view(buffer.store, array->ByteOffset(),
+                             array->Length());
+    if (reinterpret_cast<uintptr_t>(view.data()) % sizeof(T) != 0)
+      return false;
+    *out = view;
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_SHARED_ARRAY_BUFFER_H_
@@ -0,0 +1,131 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/string_cache.h"
+
+#include <string.h>
+
+#include <atomic>
+
+#include "native_mate/per_isolate_data.h"
+
+namespace mate {
+
+namespace {
+
+std::atomic<bool> g_enabled(false);
+std::atomic<size_t> g_capacity(StringCache::kDefaultCapacity);
+
+// FNV-1a.
+uint32_t HashString(const base::StringPiece& str) {
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < str.length(); ++i) {
+    hash ^= static_cast<unsigned char>(str[i]);
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+// static
+void StringCache::Enable(size_t capacity) {
+  g_capacity.store(capacity, std::memory_order_relaxed);
+  g_enabled.store(true, std::memory_order_relaxed);
+}
+
+// static
+void StringCache::Disable() {
+  g_enabled.store(false, std::memory_order_relaxed);
+}
+
+// static
+bool StringCache::IsEnabled() {
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+// static
+StringCache* StringCache::From(v8::Isolate* isolate) {
+  PerIsolateData* data = PerIsolateData::From(isolate);
+  if (!data->string_cache())
+    data->set_string_cache(
+        new StringCache(isolate, g_capacity.load(std::memory_order_relaxed)));
+  return data->string_cache();
+}
+
+StringCache::StringCache(v8::Isolate* isolate, size_t capacity)
+    : isolate_(isolate), set_mask_(0), clock_(0) {
+  // The number of sets is rounded up to a power of two.
+  size_t sets = 1;
+  while (sets * kWays < capacity)
+    sets *= 2;
+  set_mask_ = sets - 1;
+  entries_.resize(sets * kWays);
+}
+
+StringCache::~StringCache() {
+  Clear();
+}
+
+v8::Local<v8::String> StringCache::Get(const base::StringPiece& str) {
+  if (str.length() > kMaxLength)
+    return MATE_STRING_NEW_FROM_UTF8(isolate_, str.data(),
+                                     static_cast<int>(str.length()));
+
+  uint32_t hash = HashString(str);
+  Entry* set = &entries_[(hash & set_mask_) * kWays];
+  Entry* victim = NULL;
+  for (size_t i = 0; i < kWays; ++i) {
+    Entry* entry = &set[i];
+    if (entry->string.IsEmpty()) {
+      if (!victim || !victim->string.IsEmpty())
+        victim = entry;
+      continue;
+    }
+    if (entry->hash == hash && entry->length == str.length() &&
+        memcmp(entry->data, str.data(), str.length()) == 0) {
+      entry->last_use = ++clock_;
+      ++stats_.hits;
+      return v8::Local<v8::String>::New(isolate_, entry->string);
+    }
+    if (!victim ||
+        (!victim->string.IsEmpty() && entry->last_use < victim->last_use))
+      victim = entry;
+  }
+
+  ++stats_.misses;
+  v8::Local<v8::String> result = MATE_STRING_NEW_SYMBOL(
+      isolate_, str.data(), static_cast<int>(str.length()));
+  if (result.IsEmpty())
+    return result;
+  if (victim->string.IsEmpty())
+    ++stats_.size;
+  else
+    ++stats_.evictions;
+  victim->hash = hash;
+  victim->last_use = ++clock_;
+  victim->length = static_cast<uint32_t>(str.length());
+  memcpy(victim->data, str.data(), str.length());
+  victim->string.Reset(isolate_, result);
+  return result;
+}
+
+void StringCache::Clear() {
+  for (size_t i = 0; i < entries_.size(); ++i)
+    entries_[i].string.Reset();
+  stats_.size = 0;
+}
+
+v8::Local<v8::Value> Converter<CachedString>::ToV8(v8::Isolate* isolate,
+                                                   const CachedString& val) {
+  return StringCache::From(isolate)->Get(val.value);
+}
+
+bool Converter<CachedString>::FromV8(v8::Isolate* isolate,
+                                     v8::Local<v8::Value> val,
+                                     CachedString* out) {
+  return ConvertFromV8(isolate, val, &out->value);
+}
+
+}  // namespace mate
@@ -0,0 +1,121 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_STRING_CACHE_H_
+#define NATIVE_MATE_STRING_CACHE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/basictypes.h"
+#include "base/strings/string_piece.h"
+#include "native_mate/converter.h"
+#include "native_mate/struct_converter.h"
+
+namespace mate {
+
+// Counters of a StringCache, read with GetStats().
+struct StringCacheStats {
+  StringCacheStats() : hits(0), misses(0), evictions(0), size(0) {}
+
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t evictions;
+  uint64_t size;
+};
+
+// StringCache maps short strings to internalized V8 strings, so converting
+// the same value again, like a status code or a country code, reuses one
+// string instead of allocating a new one each time. Strings that are equal
+// in JavaScript are then also the same string, which makes comparing them
+// cheap.
+//
+// The cache is per isolate and holds at most |capacity| strings of up to
+// kMaxLength bytes, in sets of kWays entries, evicting the least recently
+// used entry of a set. It is off by default, once enabled the converters of
+// std::string and base::StringPiece use it in every isolate:
+//
+//   mate::StringCache::Enable(4096);
+//
+// CachedString uses the cache even when it is not enabled.
+class StringCache {
+ public:
+  static const size_t kMaxLength = 32;
+  static const size_t kWays = 4;
+  static const size_t kDefaultCapacity = 1024;
+
+  // Turns the cache on for the converters, the caches of the isolates are
+  // created with |capacity| entries.
+  static void Enable(size_t capacity);
+  static void Disable();
+  static bool IsEnabled();
+
+  // Returns the cache of |isolate|, creating it on first use. Finding it
+  // reads an isolate data slot and takes no lock.
+  static StringCache* From(v8::Isolate* isolate);
+
+  StringCache(v8::Isolate* isolate, size_t capacity);
+  ~StringCache();
+
+  // Returns the internalized string of |str|. Strings longer than kMaxLength
+  // are not cached and a new string is returned.
+  v8::Local<v8::String> Get(const base::StringPiece& str);
+
+  // Releases all the cached strings.
+  void Clear();
+
+  StringCacheStats GetStats() const { return stats_; }
+
+ private:
+  struct Entry {
+    Entry() : hash(0), last_use(0), length(0) {}
+
+    uint32_t hash;
+    uint32_t last_use;
+    uint32_t length;
+    char data[kMaxLength];
+    v8::UniquePersistent<v8::String> string;
+  };
+
+  v8::Isolate* isolate_;
+  size_t set_mask_;
+  uint32_t clock_;
+  std::vector<Entry> entries_;
+  StringCacheStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(StringCache);
+};
+
+// CachedString is a string that is always converted through the StringCache
+// of the isolate, for values known to repeat:
+//
+//   std::vector<mate::CachedString> GetCountryCodes();
+struct CachedString {
+  CachedString() {}
+  explicit CachedString(const base::StringPiece& value)
+      : value(value.as_string()) {}
+
+  std::string value;
+};
+
+template<>
+struct Converter<CachedString> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const CachedString& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     CachedString* out);
+};
+
+}  // namespace mate
+
+MATE_STRUCT(mate::StringCacheStats,
+            MATE_FIELD(hits, "hits"),
+            MATE_FIELD(misses, "misses"),
+            MATE_FIELD(evictions, "evictions"),
+            MATE_FIELD(size, "size"))
+
+#endif  // NATIVE_MATE_STRING_CACHE_H_
@@ -0,0 +1,171 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_STRUCT_CONVERTER_H_
+#define NATIVE_MATE_STRUCT_CONVERTER_H_
+
+#include <tuple>
+#include <utility>
+
+#include "native_mate/converter.h"
+#include "native_mate/key_set.h"
+#include "native_mate/record_template.h"
+
+namespace mate {
+
+// MATE_STRUCT generates the Converter of a plain struct from a list of its
+// members and their names in JavaScript. It must be used in the global
+// namespace, after the struct and the converters of its members:
+//
+//   struct Size { int width; int height; };
+//   MATE_STRUCT(Size, MATE_FIELD(width, "width"), MATE_FIELD(height, "height"))
+//
+// ToV8 creates objects from a RecordTemplate, so all the objects of a struct
+// share one hidden class. FromV8 requires an object, members whose property
+// is undefined keep the value of T() and any other property that fails to
+// convert fails the whole conversion. The keys are cached per isolate and the
+// members are converted in the order they are listed.
+#define MATE_STRUCT(type, ...)                                             \
+  namespace mate {                                                         \
+  template<>                                                               \
+  struct StructTraits<type> {                                              \
+    typedef type Type;                                                     \
+    typedef decltype(std::make_tuple(__VA_ARGS__)) Fields;                 \
+    static Fields GetFields() { return std::make_tuple(__VA_ARGS__); }     \
+  };                                                                       \
+  template<>                                                               \
+  struct Converter<type> : public internal::StructConverter<type> {};     \
+  }
+
+#define MATE_FIELD(member, name) \
+  ::mate::internal::MakeStructField(name, &Type::member)
+
+// Specialized by MATE_STRUCT, provides the std::tuple of the struct's fields.
+template<typename T>
+struct StructTraits {};
+
+namespace internal {
+
+template<typename T, typename M>
+struct StructField {
+  typedef M MemberType;
+
+  const char* name;
+  M T::* member;
+};
+
+template<typename T, typename M>
+StructField<T, M> MakeStructField(const char* name, M T::* member) {
+  StructField<T, M> field = { name, member };
+  return field;
+}
+
+// Walks the fields of a struct at compile time, from field I to the end.
+template<typename T, size_t I, size_t N>
+struct StructFieldsWalker {
+  typedef typename StructTraits<T>::Fields Fields;
+
+  static const char* GetName(const Fields& fields, size_t index) {
+    if (index == I)
+      return std::get<I>(fields).name;
+    return StructFieldsWalker<T, I + 1, N>::GetName(fields, index);
+  }
+
+  static void ToV8(v8::Isolate* isolate,
+                   const Fields& fields,
+                   const T& in,
+                   v8::Local<v8::Value>* values) {
+    values[I] = ConvertToV8(isolate, in.*(std::get<I>(fields).member));
+    StructFieldsWalker<T, I + 1, N>::ToV8(isolate, fields, in, values);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Context> context,
+                     const Fields& fields,
+                     v8::Local<v8::Object> object,
+                     const PerIsolateData::KeyList& keys,
+                     T* out) {
+    v8::Local<v8::Value> val;
+    if (!object->Get(context, keys[I].Get(isolate)).ToLocal(&val))
+      return false;
+    if (!val->IsUndefined() &&
+        !ConvertFromV8(isolate, val, &(out->*(std::get<I>(fields).member))))
+      return false;
+    return StructFieldsWalker<T, I + 1, N>::FromV8(isolate, context, fields,
+                                                   object, keys, out);
+  }
+};
+
+template<typename T, size_t N>
+struct StructFieldsWalker<T, N, N> {
+  typedef typename StructTraits<T>::Fields Fields;
+
+  static const char* GetName(const Fields& fields, size_t index) {
+    return NULL;
+  }
+  static void ToV8(v8::Isolate* isolate,
+                   const Fields& fields,
+                   const T& in,
+                   v8::Local<v8::Value>* values) {}
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Context> context,
+                     const Fields& fields,
+                     v8::Local<v8::Object> object,
+                     const PerIsolateData::KeyList& keys,
+                     T* out) {
+    return true;
+  }
+};
+
+template<typename T>
+struct StructConverter {
+  typedef typename StructTraits<T>::Fields Fields;
+  static const size_t kFieldCount = std::tuple_size<Fields>::value;
+  typedef StructFieldsWalker<T, 0, kFieldCount> Walker;
+
+  static_assert(kFieldCount > 0, "MATE_STRUCT needs at least one field");
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, const T& val) {
+    v8::Local<v8::Value> values[kFieldCount];
+    Walker::ToV8(isolate, StructTraits<T>::GetFields(), val, values);
+    return GetRecordTemplate().NewWithValues(isolate, values);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     T* out) {
+    if (!val->IsObject())
+      return false;
+    // Value-initialized, so the members of an aggregate that are left out
+    // are zero rather than indeterminate.
+    T result = T();
+    if (!Walker::FromV8(isolate,
+                        isolate->GetCurrentContext(),
+                        StructTraits<T>::GetFields(),
+                        v8::Local<v8::Object>::Cast(val),
+                        GetRecordTemplate().keys().GetKeyList(isolate),
+                        &result))
+      return false;
+    *out = std::move(result);
+    return true;
+  }
+
+  // The key set and record template only hold constants, so they are
+  // initialized statically and need no guard.
+  static const RecordTemplate& GetRecordTemplate() {
+    static const KeySet keys(&GetName, kFieldCount);
+    static const RecordTemplate record(keys);
+    return record;
+  }
+
+  static const char* GetName(size_t index) {
+    return Walker::GetName(StructTraits<T>::GetFields(), index);
+  }
+};
+
+}  // namespace internal
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_STRUCT_CONVERTER_H_
@@ -0,0 +1,268 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_THREAD_SAFE_FUNCTION_H_
+#define NATIVE_MATE_THREAD_SAFE_FUNCTION_H_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <utility>
+
+#include "base/basictypes.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ref_counted_delete_on_message_loop.h"
+#include "base/single_thread_task_runner.h"
+#include "base/thread_task_runner_handle.h"
+#include "native_mate/converter.h"
+#include "native_mate/struct_converter.h"
+
+namespace mate {
+
+// Counters of a ThreadSafeFunction, read with GetStats().
+struct ThreadSafeFunctionStats {
+  ThreadSafeFunctionStats()
+      : pushed(0), delivered(0), batches(0), max_batch_size(0),
+        queue_depth(0), peak_queue_depth(0) {}
+
+  uint64_t pushed;
+  uint64_t delivered;
+  uint64_t batches;
+  uint32_t max_batch_size;
+  uint32_t queue_depth;
+  uint32_t peak_queue_depth;
+};
+
+namespace internal {
+
+// Multi-producer single-consumer queue, after Dmitry Vyukov's intrusive
+// queue. Push is wait-free and may be called from any thread, Pop must only
+// be called from one thread. Pop can miss an item whose Push has not
+// finished yet, the pusher sees it afterwards and schedules another drain.
+template<typename T>
+class MPSCQueue {
+ public:
+  MPSCQueue() : head_(new Node), tail_(head_.load(std::memory_order_relaxed)) {
+  }
+
+  ~MPSCQueue() {
+    while (tail_) {
+      Node* next = tail_->next.load(std::memory_order_relaxed);
+      delete tail_;
+      tail_ = next;
+    }
+  }
+
+  void Push(T value) {
+    Node* node = new Node;
+    node->value = std::move(value);
+    Node* prev = head_.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+  }
+
+  bool Pop(T* out) {
+    Node* tail = tail_;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next)
+      return false;
+    *out = std::move(next->value);
+    tail_ = next;
+    delete tail;
+    return true;
+  }
+
+ private:
+  struct Node {
+    Node() : next(NULL) {}
+
+    std::atomic<Node*> next;
+    T value;
+  };
+
+  std::atomic<Node*> head_;  // Written by producers.
+  Node* tail_;  // Owned by the consumer.
+
+  DISALLOW_COPY_AND_ASSIGN(MPSCQueue);
+};
+
+}  // namespace internal
+
+// ThreadSafeFunction lets any thread send values to a JavaScript function.
+// Pushed values are queued without locking and delivered on the thread that
+// created the ThreadSafeFunction, in batches: the function is called with an
+// array of up to |max_batch_size| values converted by Converter<T>::ToV8, in
+// one HandleScope. While a delivery is scheduled further pushes only enqueue,
+// so a fast producer costs one task per batch instead of one per value.
+//
+//   scoped_refptr<ThreadSafeFunction<Sample>> sink =
+//       ThreadSafeFunction<Sample>::Create(isolate, callback);
+//   // On a worker thread:
+//   sink->Push(sample);
+//
+// To call a method of a Wrappable pass its wrapper as |receiver|. T must be
+// default constructible and movable. Close() stops the delivery, values that
+// are still queued are dropped. The JavaScript handles are released on the
+// creating thread, whichever thread drops the last reference.
+template<typename T>
+class ThreadSafeFunction
+    : public base::RefCountedDeleteOnMessageLoop<ThreadSafeFunction<T> > {
+ public:
+  static scoped_refptr<ThreadSafeFunction> Create(
+      v8::Isolate* isolate,
+      v8::Local<v8::Function> function,
+      v8::Local<v8::Value> receiver = v8::Local<v8::Value>(),
+      uint32_t max_batch_size = 1024) {
+    return new ThreadSafeFunction(isolate, function, receiver, max_batch_size);
+  }
+
+  // Queues |value| and returns false if the function has been closed. Can be
+  // called from any thread.
+  bool Push(T value) {
+    if (closed_.load(std::memory_order_acquire))
+      return false;
+    // The counters go up before the value is queued, so the drain, which
+    // may pop it right away, never takes the depth below zero.
+    pushed_.fetch_add(1, std::memory_order_relaxed);
+    uint32_t depth = depth_.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t peak = peak_depth_.load(std::memory_order_relaxed);
+    while (depth > peak &&
+           !peak_depth_.compare_exchange_weak(peak, depth,
+                                              std::memory_order_relaxed)) {
+    }
+    queue_.Push(std::move(value));
+    ScheduleDrain();
+    return true;
+  }
+
+  // Stops the delivery. Can be called from any thread.
+  void Close() {
+    closed_.store(true, std::memory_order_release);
+    ScheduleDrain();
+  }
+
+  ThreadSafeFunctionStats GetStats() const {
+    ThreadSafeFunctionStats stats;
+    stats.pushed = pushed_.load(std::memory_order_relaxed);
+    stats.delivered = delivered_.load(std::memory_order_relaxed);
+    stats.batches = batches_.load(std::memory_order_relaxed);
+    stats.max_batch_size = max_batch_.load(std::memory_order_relaxed);
+    stats.queue_depth = depth_.load(std::memory_order_relaxed);
+    stats.peak_queue_depth = peak_depth_.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+ private:
+  friend class base::RefCountedDeleteOnMessageLoop<ThreadSafeFunction>;
+  friend class base::DeleteHelper<ThreadSafeFunction>;
+
+  ThreadSafeFunction(v8::Isolate* isolate,
+                     v8::Local<v8::Function> function,
+                     v8::Local<v8::Value> receiver,
+                     uint32_t max_batch_size)
+      : base::RefCountedDeleteOnMessageLoop<ThreadSafeFunction>(
+            base::ThreadTaskRunnerHandle::Get()),
+        isolate_(isolate),
+        task_runner_(base::ThreadTaskRunnerHandle::Get()),
+        function_(isolate, function),
+        max_batch_size_(max_batch_size > 0 ? max_batch_size : 1),
+        closed_(false),
+        drain_scheduled_(false),
+        pushed_(0),
+        delivered_(0),
+        batches_(0),
+        max_batch_(0),
+        depth_(0),
+        peak_depth_(0) {
+    if (!receiver.IsEmpty())
+      receiver_.Reset(isolate, receiver);
+  }
+
+  ~ThreadSafeFunction() {
+    function_.Reset();
+    receiver_.Reset();
+  }
+
+  void ScheduleDrain() {
+    if (!drain_scheduled_.exchange(true, std::memory_order_acq_rel))
+      task_runner_->PostTask(FROM_HERE,
+                             base::Bind(&ThreadSafeFunction::Drain, this));
+  }
+
+  // Delivers one batch on the creating thread, and schedules the next one if
+  // values remain so other tasks can run in between.
+  void Drain() {
+    drain_scheduled_.store(false, std::memory_order_release);
+
+    T value;
+    if (closed_.load(std::memory_order_acquire)) {
+      while (queue_.Pop(&value))
+        depth_.fetch_sub(1, std::memory_order_relaxed);
+      function_.Reset();
+      receiver_.Reset();
+      return;
+    }
+
+    v8::HandleScope handle_scope(isolate_);
+    v8::Local<v8::Function> function =
+        v8::Local<v8::Function>::New(isolate_, function_);
+    v8::Local<v8::Context> context = function->CreationContext();
+    v8::Context::Scope context_scope(context);
+    v8::Local<v8::Array> batch = MATE_ARRAY_NEW(isolate_, 0);
+    uint32_t count = 0;
+    while (count < max_batch_size_ && queue_.Pop(&value)) {
+      ignore_result(batch->CreateDataProperty(
+          context, count, ConvertToV8(isolate_, value)));
+      ++count;
+    }
+    if (count == 0)
+      return;
+
+    depth_.fetch_sub(count, std::memory_order_relaxed);
+    delivered_.fetch_add(count, std::memory_order_relaxed);
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    if (count > max_batch_.load(std::memory_order_relaxed))
+      max_batch_.store(count, std::memory_order_relaxed);
+
+    v8::Local<v8::Value> receiver = MATE_UNDEFINED(isolate_);
+    if (!receiver_.IsEmpty())
+      receiver = v8::Local<v8::Value>::New(isolate_, receiver_);
+    v8::Local<v8::Value> argv[] = { batch };
+    ignore_result(function->Call(context, receiver, 1, argv));
+
+    if (count == max_batch_size_)
+      ScheduleDrain();
+  }
+
+  v8::Isolate* isolate_;
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  v8::UniquePersistent<v8::Function> function_;
+  v8::UniquePersistent<v8::Value> receiver_;
+  const uint32_t max_batch_size_;
+
+  internal::MPSCQueue<T> queue_;
+  std::atomic<bool> closed_;
+  std::atomic<bool> drain_scheduled_;
+
+  std::atomic<uint64_t> pushed_;
+  std::atomic<uint64_t> delivered_;
+  std::atomic<uint64_t> batches_;
+  std::atomic<uint32_t> max_batch_;  // Only written by the consumer.
+  std::atomic<uint32_t> depth_;
+  std::atomic<uint32_t> peak_depth_;
+
+  DISALLOW_COPY_AND_ASSIGN(ThreadSafeFunction);
+};
+
+}  // namespace mate
+
+MATE_STRUCT(mate::ThreadSafeFunctionStats,
+            MATE_FIELD(pushed, "pushed"),
+            MATE_FIELD(delivered, "delivered"),
+            MATE_FIELD(batches, "batches"),
+            MATE_FIELD(max_batch_size, "maxBatchSize"),
+            MATE_FIELD(queue_depth, "queueDepth"),
+            MATE_FIELD(peak_queue_depth, "peakQueueDepth"))
+
+#endif  // NATIVE_MATE_THREAD_SAFE_FUNCTION_H_
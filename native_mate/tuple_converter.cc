@@ -0,0 +1,31 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/tuple_converter.h"
+
+namespace mate {
+
+namespace internal {
+
+v8::Local<v8::Array> NewArrayFromElements(v8::Isolate* isolate,
+                                          v8::Local<v8::Value>* elements,
+                                          size_t length) {
+#if MATE_V8_AT_LEAST(7, 0)
+  return v8::Array::New(isolate, elements, length);
+#else
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  v8::Local<v8::Array> result =
+      MATE_ARRAY_NEW(isolate, static_cast<int>(length));
+  for (size_t i = 0; i < length; ++i) {
+    if (!result->CreateDataProperty(context, static_cast<uint32_t>(i),
+                                    elements[i]).FromMaybe(false))
+      return v8::Local<v8::Array>();
+  }
+  return result;
+#endif
+}
+
+}  // namespace internal
+
+}  // namespace mate
@@ -0,0 +1,103 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_TUPLE_CONVERTER_H_
+#define NATIVE_MATE_TUPLE_CONVERTER_H_
+
+#include <tuple>
+#include <utility>
+
+#include "native_mate/converter.h"
+
+namespace mate {
+
+namespace internal {
+
+// Creates an array holding |elements|, in one call where V8 supports it.
+v8::Local<v8::Array> NewArrayFromElements(v8::Isolate* isolate,
+                                          v8::Local<v8::Value>* elements,
+                                          size_t length);
+
+// Converts the elements of a std::tuple or a std::pair one by one, the
+// recursion is unrolled at compile time.
+template<typename Tuple, size_t I, size_t N>
+struct TupleWalker {
+  static void ToV8(v8::Isolate* isolate,
+                   const Tuple& val,
+                   v8::Local<v8::Value>* elements) {
+    elements[I] = ConvertToV8(isolate, std::get<I>(val));
+    TupleWalker<Tuple, I + 1, N>::ToV8(isolate, val, elements);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Context> context,
+                     v8::Local<v8::Array> array,
+                     Tuple* out) {
+    v8::Local<v8::Value> element;
+    if (!array->Get(context, I).ToLocal(&element) ||
+        !ConvertFromV8(isolate, element, &std::get<I>(*out)))
+      return false;
+    return TupleWalker<Tuple, I + 1, N>::FromV8(isolate, context, array, out);
+  }
+};
+
+template<typename Tuple, size_t N>
+struct TupleWalker<Tuple, N, N> {
+  static void ToV8(v8::Isolate* isolate,
+                   const Tuple& val,
+                   v8::Local<v8::Value>* elements) {}
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Context> context,
+                     v8::Local<v8::Array> array,
+                     Tuple* out) {
+    return true;
+  }
+};
+
+// Converts a tuple-like type of N elements to and from an array of length N.
+template<typename Tuple, size_t N>
+struct TupleConverter {
+  typedef TupleWalker<Tuple, 0, N> Walker;
+
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate, const Tuple& val) {
+    v8::Local<v8::Value> elements[N > 0 ? N : 1];
+    Walker::ToV8(isolate, val, elements);
+    return NewArrayFromElements(isolate, elements, N);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     Tuple* out) {
+    if (!val->IsArray())
+      return false;
+    v8::Local<v8::Array> array = v8::Local<v8::Array>::Cast(val);
+    if (array->Length() != N)
+      return false;
+    Tuple result;
+    if (!Walker::FromV8(isolate, isolate->GetCurrentContext(), array,
+                        &result))
+      return false;
+    *out = std::move(result);
+    return true;
+  }
+};
+
+}  // namespace internal
+
+// std::pair and std::tuple are converted to fixed-length arrays, so several
+// values can be returned at once:
+//
+//   std::tuple<int, std::string> GetEntry();  // Returns [1, "name"].
+//   const [id, name] = obj.getEntry();
+template<typename A, typename B>
+struct Converter<std::pair<A, B> >
+    : public internal::TupleConverter<std::pair<A, B>, 2> {};
+
+template<typename... Ts>
+struct Converter<std::tuple<Ts...> >
+    : public internal::TupleConverter<std::tuple<Ts...>, sizeof...(Ts)> {};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_TUPLE_CONVERTER_H_
@@ -0,0 +1,57 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_TYPED_ARRAY_TRAITS_H_
+#define NATIVE_MATE_TYPED_ARRAY_TRAITS_H_
+
+#include <stdint.h>
+
+#include "v8/include/v8.h"
+
+namespace mate {
+
+// TypedArrayTraits maps a C++ arithmetic type to the typed array that stores
+// it with the same representation, so values can be copied in bulk:
+//
+//   typedef TypedArrayTraits<T> Traits;
+//   if (Traits::kIsSupported && Traits::IsTypedArray(value)) { ... }
+//   v8::Local<typename Traits::ArrayType> array =
+//       Traits::ArrayType::New(buffer, byte_offset, length);
+template<typename T>
+struct TypedArrayTraits {
+  static const bool kIsSupported = false;
+};
+
+#define MATE_TYPED_ARRAY_TRAITS(c_type, v8_type)                \
+  template<>                                                    \
+  struct TypedArrayTraits<c_type> {                             \
+    static const bool kIsSupported = true;                      \
+    typedef v8::v8_type ArrayType;                              \
+    static bool IsTypedArray(v8::Local<v8::Value> val) {        \
+      return val->Is##v8_type();                                \
+    }                                                           \
+  }
+
+MATE_TYPED_ARRAY_TRAITS(int8_t, Int8Array);
+MATE_TYPED_ARRAY_TRAITS(uint8_t, Uint8Array);
+MATE_TYPED_ARRAY_TRAITS(int16_t, Int16Array);
+MATE_TYPED_ARRAY_TRAITS(uint16_t, Uint16Array);
+MATE_TYPED_ARRAY_TRAITS(int32_t, Int32Array);
+MATE_TYPED_ARRAY_TRAITS(uint32_t, Uint32Array);
+MATE_TYPED_ARRAY_TRAITS(float, Float32Array);
+MATE_TYPED_ARRAY_TRAITS(double, Float64Array);
+
+#undef MATE_TYPED_ARRAY_TRAITS
+
+// Returns the first element of |view|'s contents.
+template<typename T>
+T* GetTypedArrayData(v8::Local<v8::ArrayBufferView> view) {
+  return reinterpret_cast<T*>(
+      static_cast<char*>(view->Buffer()->GetContents().Data()) +
+      view->ByteOffset());
+}
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_TYPED_ARRAY_TRAITS_H_
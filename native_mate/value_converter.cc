@@ -0,0 +1,434 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/value_converter.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/strings/string_number_conversions.h"
+#include "base/values.h"
+
+namespace mate {
+
+namespace {
+
+const size_t kJsonConversionThreshold = MATE_JSON_CONVERSION_THRESHOLD;
+const size_t kMaxDepth = MATE_VALUE_CONVERSION_MAX_DEPTH;
+
+// Counts the values of |value| into |count|, stopping once it gets to
+// |limit|.
+void CountValues(const base::Value& value, size_t limit, size_t* count) {
+  ++*count;
+  const base::DictionaryValue* dict;
+  const base::ListValue* list;
+  if (value.GetAsDictionary(&dict)) {
+    for (base::DictionaryValue::Iterator it(*dict);
+         !it.IsAtEnd() && *count < limit; it.Advance())
+      CountValues(it.value(), limit, count);
+  } else if (value.GetAsList(&list)) {
+    for (size_t i = 0; i < list->GetSize() && *count < limit; ++i) {
+      const base::Value* element;
+      if (list->Get(i, &element))
+        CountValues(*element, limit, count);
+    }
+  }
+}
+
+void AppendJsonString(const std::string& str, std::string* json) {
+  json->push_back('"');
+  size_t begin = 0;
+  for (size_t i = 0; i < str.size(); ++i) {
+    unsigned char c = static_cast<unsigned char>(str[i]);
+    if (c >= 0x20 && c != '"' && c != '\\')
+      continue;
+    json->append(str, begin, i - begin);
+    begin = i + 1;
+    if (c == '"' || c == '\\') {
+      json->push_back('\\');
+      json->push_back(c);
+    } else {
+      char escape[8];
+      snprintf(escape, sizeof(escape), "\\u%04x", c);
+      json->append(escape);
+    }
+  }
+  json->append(str, begin, std::string::npos);
+  json->push_back('"');
+}
+
+// Appends |value| to |json|, returns false when JSON can not hold it.
+bool WriteJson(const base::Value& value, std::string* json) {
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      json->append("null");
+      return true;
+    case base::Value::TYPE_BOOLEAN: {
+      bool boolean = false;
+      value.GetAsBoolean(&boolean);
+      json->append(boolean ? "true" : "false");
+      return true;
+    }
+    case base::Value::TYPE_INTEGER: {
+      int integer = 0;
+      value.GetAsInteger(&integer);
+      json->append(base::IntToString(integer));
+      return true;
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double number = 0;
+      value.GetAsDouble(&number);
+      if (!std::isfinite(number))
+        return false;
+      json->append(base::DoubleToString(number));
+      return true;
+    }
+    case base::Value::TYPE_STRING: {
+      std::string str;
+      value.GetAsString(&str);
+      AppendJsonString(str, json);
+      return true;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      const base::DictionaryValue* dict;
+      value.GetAsDictionary(&dict);
+      json->push_back('{');
+      bool first = true;
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        if (!first)
+          json->push_back(',');
+        first = false;
+        AppendJsonString(it.key(), json);
+        json->push_back(':');
+        if (!WriteJson(it.value(), json))
+          return false;
+      }
+      json->push_back('}');
+      return true;
+    }
+    case base::Value::TYPE_LIST: {
+      const base::ListValue* list;
+      value.GetAsList(&list);
+      json->push_back('[');
+      for (size_t i = 0; i < list->GetSize(); ++i) {
+        if (i > 0)
+          json->push_back(',');
+        const base::Value* element;
+        if (!list->Get(i, &element) || !WriteJson(*element, json))
+          return false;
+      }
+      json->push_back(']');
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+v8::Local<v8::Value> ValueToV8(v8::Isolate* isolate,
+                               v8::Local<v8::Context> context,
+                               const base::Value& value) {
+  switch (value.GetType()) {
+    case base::Value::TYPE_NULL:
+      return v8::Null(isolate);
+    case base::Value::TYPE_BOOLEAN: {
+      bool boolean = false;
+      value.GetAsBoolean(&boolean);
+      return ConvertToV8(isolate, boolean);
+    }
+    case base::Value::TYPE_INTEGER: {
+      int integer = 0;
+      value.GetAsInteger(&integer);
+      return ConvertToV8(isolate, integer);
+    }
+    case base::Value::TYPE_DOUBLE: {
+      double number = 0;
+      value.GetAsDouble(&number);
+      return ConvertToV8(isolate, number);
+    }
+    case base::Value::TYPE_STRING: {
+      std::string str;
+      value.GetAsString(&str);
+      return ConvertToV8(isolate, str);
+    }
+    case base::Value::TYPE_BINARY: {
+      const base::BinaryValue& binary =
+          static_cast<const base::BinaryValue&>(value);
+      v8::Local<v8::ArrayBuffer> buffer =
+          v8::ArrayBuffer::New(isolate, binary.GetSize());
+      if (binary.GetSize() > 0)
+        memcpy(buffer->GetContents().Data(), binary.GetBuffer(),
+               binary.GetSize());
+      return buffer;
+    }
+    case base::Value::TYPE_DICTIONARY: {
+      v8::EscapableHandleScope handle_scope(isolate);
+      const base::DictionaryValue* dict;
+      value.GetAsDictionary(&dict);
+      v8::Local<v8::Object> object = MATE_OBJECT_NEW(isolate);
+      for (base::DictionaryValue::Iterator it(*dict); !it.IsAtEnd();
+           it.Advance()) {
+        v8::Local<v8::Value> property = ValueToV8(isolate, context, it.value());
+        if (property.IsEmpty() ||
+            !object->CreateDataProperty(context,
+                                        StringToV8(isolate, it.key()),
+                                        property).FromMaybe(false))
+          return v8::Local<v8::Value>();
+      }
+      return handle_scope.Escape(object);
+    }
+    case base::Value::TYPE_LIST: {
+      v8::EscapableHandleScope handle_scope(isolate);
+      const base::ListValue* list;
+      value.GetAsList(&list);
+      v8::Local<v8::Array> array = MATE_ARRAY_NEW(isolate, list->GetSize());
+      for (size_t i = 0; i < list->GetSize(); ++i) {
+        const base::Value* element;
+        if (!list->Get(i, &element))
+          continue;
+        v8::Local<v8::Value> item = ValueToV8(isolate, context, *element);
+        if (item.IsEmpty() ||
+            !array->CreateDataProperty(context, static_cast<uint32_t>(i),
+                                       item).FromMaybe(false))
+          return v8::Local<v8::Value>();
+      }
+      return handle_scope.Escape(array);
+    }
+    default:
+      return v8::Null(isolate);
+  }
+}
+
+enum ConversionResult {
+  CONVERTED,
+  // The value is left out, as JSON.stringify does with undefined.
+  SKIPPED,
+  FAILED,
+};
+
+struct FromV8State {
+  v8::Isolate* isolate;
+  v8::Local<v8::Context> context;
+  v8::Local<v8::String> to_json;
+  // The objects being converted, from the root down, to detect cycles the
+  // way JSON.stringify does.
+  std::vector<v8::Local<v8::Object> > stack;
+};
+
+ConversionResult ValueFromV8(FromV8State* state,
+                             v8::Local<v8::Value> val,
+                             bool plain,
+                             std::unique_ptr<base::Value>* out);
+
+ConversionResult ArrayFromV8(FromV8State* state,
+                             v8::Local<v8::Array> array,
+                             bool plain,
+                             std::unique_ptr<base::Value>* out) {
+  std::unique_ptr<base::ListValue> list(new base::ListValue);
+  uint32_t length = array->Length();
+  for (uint32_t i = 0; i < length; ++i) {
+    v8::HandleScope handle_scope(state->isolate);
+    v8::Local<v8::Value> value;
+    if (!array->Get(state->context, i).ToLocal(&value))
+      return FAILED;
+    std::unique_ptr<base::Value> element;
+    ConversionResult result = ValueFromV8(state, value, plain, &element);
+    if (result == SKIPPED)
+      element = base::Value::CreateNullValue();
+    else if (result != CONVERTED)
+      return result;
+    list->Append(std::move(element));
+  }
+  out->reset(list.release());
+  return CONVERTED;
+}
+
+ConversionResult ObjectFromV8(FromV8State* state,
+                              v8::Local<v8::Object> object,
+                              bool plain,
+                              std::unique_ptr<base::Value>* out) {
+  v8::Local<v8::Array> keys;
+  if (!object->GetOwnPropertyNames(state->context).ToLocal(&keys))
+    return FAILED;
+  std::unique_ptr<base::DictionaryValue> dict(new base::DictionaryValue);
+  uint32_t length = keys->Length();
+  for (uint32_t i = 0; i < length; ++i) {
+    v8::HandleScope handle_scope(state->isolate);
+    v8::Local<v8::Value> key;
+    v8::Local<v8::String> name;
+    v8::Local<v8::Value> value;
+    if (!keys->Get(state->context, i).ToLocal(&key) ||
+        !key->ToString(state->context).ToLocal(&name) ||
+        !object->Get(state->context, key).ToLocal(&value))
+      return FAILED;
+    std::unique_ptr<base::Value> property;
+    ConversionResult result = ValueFromV8(state, value, plain, &property);
+    if (result == SKIPPED)
+      continue;
+    if (result != CONVERTED)
+      return result;
+    std::string name_string;
+    ConvertFromV8(state->isolate, name, &name_string);
+    dict->SetWithoutPathExpansion(name_string, std::move(property));
+  }
+  out->reset(dict.release());
+  return CONVERTED;
+}
+
+// Converts |val| the way JSON.stringify sees it, for values the walk can not
+// convert itself, like objects with a toJSON method or proxies. The value is
+// read once, by JSON.stringify, and the plain copy JSON.parse returns is
+// walked instead.
+ConversionResult JsonFromV8(FromV8State* state,
+                            v8::Local<v8::Value> val,
+                            std::unique_ptr<base::Value>* out) {
+  v8::HandleScope handle_scope(state->isolate);
+  v8::Local<v8::Value> json;
+  if (!v8::JSON::Stringify(state->context, val).ToLocal(&json))
+    return FAILED;
+  // JSON.stringify returns undefined for a toJSON that returns undefined.
+  if (!json->IsString())
+    return SKIPPED;
+  v8::Local<v8::Value> copy;
+  if (!v8::JSON::Parse(state->context, v8::Local<v8::String>::Cast(json))
+           .ToLocal(&copy))
+    return FAILED;
+  return ValueFromV8(state, copy, true, out);
+}
+
+// Converts |val| into |out|. Inside a |plain| value, which JSON.parse
+// created, objects are taken as they are.
+ConversionResult ValueFromV8(FromV8State* state,
+                             v8::Local<v8::Value> val,
+                             bool plain,
+                             std::unique_ptr<base::Value>* out) {
+  if (val->IsNull()) {
+    *out = base::Value::CreateNullValue();
+  } else if (val->IsBoolean()) {
+    out->reset(new base::FundamentalValue(val->IsTrue()));
+  } else if (val->IsInt32()) {
+    out->reset(new base::FundamentalValue(
+        static_cast<int>(v8::Local<v8::Int32>::Cast(val)->Value())));
+  } else if (val->IsNumber()) {
+    // JSON.stringify writes NaN and the infinities as null.
+    double number = v8::Local<v8::Number>::Cast(val)->Value();
+    if (std::isfinite(number))
+      out->reset(new base::FundamentalValue(number));
+    else
+      *out = base::Value::CreateNullValue();
+  } else if (val->IsString()) {
+    std::string str;
+    ConvertFromV8(state->isolate, val, &str);
+    out->reset(new base::StringValue(str));
+  } else if (val->IsUndefined() || val->IsFunction() || val->IsSymbol()) {
+    return SKIPPED;
+  } else if (val->IsObject()) {
+    v8::Local<v8::Object> object = v8::Local<v8::Object>::Cast(val);
+    if (!plain &&
+        (object->IsProxy() || object->IsNumberObject() ||
+         object->IsStringObject() || object->IsBooleanObject() ||
+         object->Has(state->context, state->to_json).FromMaybe(true)))
+      return JsonFromV8(state, val, out);
+    if (state->stack.size() >= kMaxDepth ||
+        std::find(state->stack.begin(), state->stack.end(), object) !=
+            state->stack.end())
+      return FAILED;
+    state->stack.push_back(object);
+    ConversionResult result =
+        val->IsArray()
+            ? ArrayFromV8(state, v8::Local<v8::Array>::Cast(val), plain, out)
+            : ObjectFromV8(state, object, plain, out);
+    state->stack.pop_back();
+    return result;
+  } else {
+    // Leaves values JSON can not hold, like BigInts, to JSON.stringify.
+    return JsonFromV8(state, val, out);
+  }
+  return CONVERTED;
+}
+
+v8::Local<v8::Value> TreeToV8(v8::Isolate* isolate, const base::Value& val) {
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  size_t count = 0;
+  CountValues(val, kJsonConversionThreshold, &count);
+  if (count >= kJsonConversionThreshold) {
+    std::string json;
+    if (WriteJson(val, &json)) {
+      v8::Local<v8::Value> result;
+      if (!v8::JSON::Parse(context, StringToV8(isolate, json))
+               .ToLocal(&result))
+        return v8::Local<v8::Value>();
+      return result;
+    }
+  }
+  return ValueToV8(isolate, context, val);
+}
+
+// Converts |val| into |out|, returns false when it is not a JSON value.
+bool TreeFromV8(v8::Isolate* isolate,
+                v8::Local<v8::Value> val,
+                std::unique_ptr<base::Value>* out) {
+  // Exceptions thrown by getters, toJSON methods or cycles only fail the
+  // conversion.
+  v8::TryCatch try_catch(isolate);
+  v8::HandleScope handle_scope(isolate);
+  FromV8State state;
+  state.isolate = isolate;
+  state.context = isolate->GetCurrentContext();
+  state.to_json = StringToSymbol(isolate, "toJSON");
+  return ValueFromV8(&state, val, false, out) == CONVERTED;
+}
+
+}  // namespace
+
+v8::Local<v8::Value> Converter<base::Value>::ToV8(v8::Isolate* isolate,
+                                                  const base::Value& val) {
+  return TreeToV8(isolate, val);
+}
+
+v8::Local<v8::Value> Converter<base::DictionaryValue>::ToV8(
+    v8::Isolate* isolate, const base::DictionaryValue& val) {
+  return TreeToV8(isolate, val);
+}
+
+bool Converter<base::DictionaryValue>::FromV8(v8::Isolate* isolate,
+                                              v8::Local<v8::Value> val,
+                                              base::DictionaryValue* out) {
+  if (!val->IsObject() || val->IsArray() || val->IsFunction())
+    return false;
+  std::unique_ptr<base::Value> value;
+  base::DictionaryValue* dict;
+  if (!TreeFromV8(isolate, val, &value) || !value->GetAsDictionary(&dict))
+    return false;
+  out->Swap(dict);
+  return true;
+}
+
+v8::Local<v8::Value> Converter<base::ListValue>::ToV8(
+    v8::Isolate* isolate, const base::ListValue& val) {
+  return TreeToV8(isolate, val);
+}
+
+bool Converter<base::ListValue>::FromV8(v8::Isolate* isolate,
+                                        v8::Local<v8::Value> val,
+                                        base::ListValue* out) {
+  if (!val->IsArray())
+    return false;
+  std::unique_ptr<base::Value> value;
+  base::ListValue* list;
+  if (!TreeFromV8(isolate, val, &value) || !value->GetAsList(&list))
+    return false;
+  out->Swap(list);
+  return true;
+}
+
+}  // namespace mate
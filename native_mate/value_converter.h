@@ -0,0 +1,75 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_VALUE_CONVERTER_H_
+#define NATIVE_MATE_VALUE_CONVERTER_H_
+
+#include "native_mate/converter.h"
+
+// Number of values in a tree from which the base::Value converters create
+// it in V8 through JSON instead of converting the values one by one.
+#ifndef MATE_JSON_CONVERSION_THRESHOLD
+#define MATE_JSON_CONVERSION_THRESHOLD 256
+#endif
+
+// Depth of nesting from which converting a JavaScript value to a base::Value
+// fails instead of recursing further.
+#ifndef MATE_VALUE_CONVERSION_MAX_DEPTH
+#define MATE_VALUE_CONVERSION_MAX_DEPTH 1000
+#endif
+
+namespace base {
+class DictionaryValue;
+class ListValue;
+class Value;
+}  // namespace base
+
+namespace mate {
+
+// Converters of base::Value trees, like parsed JSON documents or settings.
+// Values convert as JSON would: from V8, properties that are undefined,
+// functions or symbols are left out, toJSON methods are called and cycles
+// fail the conversion. Binary values convert to ArrayBuffers.
+//
+// These converters are not in the default native_mate_files, since
+// embedders such as Electron have base::Value converters of their own. Add
+// native_mate_value_converter_files to the sources to use them.
+//
+// A small tree is converted value by value. Once a tree holds
+// MATE_JSON_CONVERSION_THRESHOLD values, ToV8 writes it into one JSON string
+// for v8::JSON::Parse, which builds deep objects much faster than setting
+// their properties one at a time. Trees with values JSON can not hold,
+// binary values and doubles that are not finite, stay on the first path.
+//
+// FromV8 always walks the value, reading each property once. Only values
+// that need JSON.stringify's rules, like objects with a toJSON method, go
+// through v8::JSON::Stringify, and the plain copy v8::JSON::Parse makes of
+// them is walked instead of the value.
+template<>
+struct Converter<base::Value> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const base::Value& val);
+};
+
+template<>
+struct Converter<base::DictionaryValue> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const base::DictionaryValue& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     base::DictionaryValue* out);
+};
+
+template<>
+struct Converter<base::ListValue> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const base::ListValue& val);
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     base::ListValue* out);
+};
+
+}  // namespace mate
+
+#endif  // NATIVE_MATE_VALUE_CONVERTER_H_
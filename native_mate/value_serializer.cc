@@ -0,0 +1,305 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#include "native_mate/value_serializer.h"
+
+#if MATE_V8_AT_LEAST(6, 8)
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "native_mate/per_isolate_data.h"
+#include "native_mate/shared_array_buffer.h"
+#include "native_mate/wrappable.h"
+
+namespace mate {
+
+namespace {
+
+void FreeToAllocator(void* data, size_t length, void* deleter_data) {
+  static_cast<v8::ArrayBuffer::Allocator*>(deleter_data)->Free(data, length);
+}
+
+void ThrowCloneError(v8::Isolate* isolate, const char* message) {
+  isolate->ThrowException(v8::Exception::Error(StringToV8(isolate, message)));
+}
+
+// Takes the contents of |buffer| and detaches it. The memory is taken over
+// when it was allocated by the isolate's allocator or comes from a
+// BackingStore, and copied otherwise.
+scoped_refptr<BackingStore> TakeArrayBuffer(v8::Isolate* isolate,
+                                            v8::Local<v8::ArrayBuffer> buffer) {
+  scoped_refptr<BackingStore> store =
+      internal::GetAttachedBackingStore(isolate, buffer);
+  if (!store) {
+    v8::ArrayBuffer::Allocator* allocator =
+        PerIsolateData::From(isolate)->array_buffer_allocator();
+    if (allocator && !buffer->IsExternal() &&
+        buffer->GetContents().AllocationMode() ==
+            v8::ArrayBuffer::Allocator::AllocationMode::kNormal) {
+      v8::ArrayBuffer::Contents contents = buffer->Externalize();
+      store = BackingStore::Wrap(contents.Data(), contents.ByteLength(),
+                                 &FreeToAllocator, allocator);
+    } else {
+      v8::ArrayBuffer::Contents contents = buffer->GetContents();
+      const uint8_t* data = static_cast<const uint8_t*>(contents.Data());
+      store = BackingStore::Take(
+          std::vector<uint8_t>(data, data + contents.ByteLength()));
+    }
+  }
+  buffer->Neuter();
+  return store;
+}
+
+}  // namespace
+
+namespace internal {
+
+class SerializerDelegate : public v8::ValueSerializer::Delegate {
+ public:
+  SerializerDelegate(v8::Isolate* isolate,
+                     SerializedValue* value,
+                     uint32_t first_shared_id)
+      : isolate_(isolate),
+        value_(value),
+        first_shared_id_(first_shared_id),
+        serializer_(NULL) {}
+
+  void set_serializer(v8::ValueSerializer* serializer) {
+    serializer_ = serializer;
+  }
+
+  // v8::ValueSerializer::Delegate:
+  void ThrowDataCloneError(v8::Local<v8::String> message) override {
+    isolate_->ThrowException(v8::Exception::Error(message));
+  }
+
+  v8::Maybe<bool> WriteHostObject(v8::Isolate* isolate,
+                                  v8::Local<v8::Object> object) override {
+    // Other host objects, like those of Node.js, may have one internal field
+    // too, so the pointer is only read from instances of wrapper templates.
+    Wrappable* wrappable = GetWrappable(isolate, object);
+    std::unique_ptr<SerializedObject> serialized;
+    if (wrappable && !wrappable->IsDestroyed())
+      serialized = wrappable->Serialize(isolate);
+    if (!serialized) {
+      ThrowCloneError(isolate, "The object could not be cloned.");
+      return v8::Nothing<bool>();
+    }
+    serializer_->WriteUint32(static_cast<uint32_t>(value_->objects_.size()));
+    value_->objects_.push_back(std::move(serialized));
+    return v8::Just(true);
+  }
+
+  v8::Maybe<uint32_t> GetSharedArrayBufferId(
+      v8::Isolate* isolate,
+      v8::Local<v8::SharedArrayBuffer> buffer) override {
+    SharedBuffer shared;
+    if (!ConvertFromV8(isolate, buffer, &shared)) {
+      ThrowCloneError(isolate, "The SharedArrayBuffer could not be shared.");
+      return v8::Nothing<uint32_t>();
+    }
+    std::vector<scoped_refptr<BackingStore> >& stores =
+        value_->shared_array_buffers_;
+    size_t index = 0;
+    while (index < stores.size() && stores[index].get() != shared.store.get())
+      ++index;
+    if (index == stores.size())
+      stores.push_back(shared.store);
+    return v8::Just(first_shared_id_ + static_cast<uint32_t>(index));
+  }
+
+ private:
+  v8::Isolate* isolate_;
+  SerializedValue* value_;
+  uint32_t first_shared_id_;
+  v8::ValueSerializer* serializer_;
+
+  DISALLOW_COPY_AND_ASSIGN(SerializerDelegate);
+};
+
+class DeserializerDelegate : public v8::ValueDeserializer::Delegate {
+ public:
+  explicit DeserializerDelegate(SerializedValue* value)
+      : value_(value), deserializer_(NULL) {}
+
+  void set_deserializer(v8::ValueDeserializer* deserializer) {
+    deserializer_ = deserializer;
+  }
+
+  // Creates the SharedArrayBuffer with the transfer id |id|.
+  v8::Local<v8::SharedArrayBuffer> NewSharedArrayBuffer(v8::Isolate* isolate,
+                                                        uint32_t id) {
+    uint32_t first_shared_id =
+        static_cast<uint32_t>(value_->array_buffers_.size());
+    if (id < first_shared_id ||
+        id - first_shared_id >= value_->shared_array_buffers_.size())
+      return v8::Local<v8::SharedArrayBuffer>();
+    v8::Local<v8::Value> buffer = ConvertToV8(
+        isolate,
+        SharedBuffer(value_->shared_array_buffers_[id - first_shared_id]));
+    if (buffer.IsEmpty() || !buffer->IsSharedArrayBuffer())
+      return v8::Local<v8::SharedArrayBuffer>();
+    return v8::Local<v8::SharedArrayBuffer>::Cast(buffer);
+  }
+
+  // v8::ValueDeserializer::Delegate:
+  v8::MaybeLocal<v8::Object> ReadHostObject(v8::Isolate* isolate) override {
+    uint32_t index;
+    if (!deserializer_->ReadUint32(&index) ||
+        index >= value_->objects_.size() || !value_->objects_[index]) {
+      ThrowCloneError(isolate, "The object could not be deserialized.");
+      return v8::MaybeLocal<v8::Object>();
+    }
+    std::unique_ptr<SerializedObject> object(
+        std::move(value_->objects_[index]));
+    v8::Local<v8::Object> wrapper = object->Deserialize(isolate);
+    if (wrapper.IsEmpty())
+      return v8::MaybeLocal<v8::Object>();
+    return wrapper;
+  }
+
+  v8::MaybeLocal<v8::SharedArrayBuffer> GetSharedArrayBufferFromId(
+      v8::Isolate* isolate, uint32_t id) override {
+    v8::Local<v8::SharedArrayBuffer> buffer = NewSharedArrayBuffer(isolate, id);
+    if (buffer.IsEmpty()) {
+      ThrowCloneError(isolate,
+                      "The SharedArrayBuffer could not be deserialized.");
+      return v8::MaybeLocal<v8::SharedArrayBuffer>();
+    }
+    return buffer;
+  }
+
+ private:
+  SerializedValue* value_;
+  v8::ValueDeserializer* deserializer_;
+
+  DISALLOW_COPY_AND_ASSIGN(DeserializerDelegate);
+};
+
+}  // namespace internal
+
+SerializedValue::SerializedValue() : data_(NULL), size_(0) {
+}
+
+SerializedValue::SerializedValue(SerializedValue&& other)
+    : data_(NULL), size_(0) {
+  *this = std::move(other);
+}
+
+SerializedValue::~SerializedValue() {
+  Reset();
+}
+
+SerializedValue& SerializedValue::operator=(SerializedValue&& other) {
+  if (this != &other) {
+    Reset();
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    array_buffers_.swap(other.array_buffers_);
+    shared_array_buffers_.swap(other.shared_array_buffers_);
+    objects_.swap(other.objects_);
+  }
+  return *this;
+}
+
+void SerializedValue::Reset() {
+  free(data_);
+  data_ = NULL;
+  size_ = 0;
+  array_buffers_.clear();
+  shared_array_buffers_.clear();
+  objects_.clear();
+}
+
+bool SerializeValue(v8::Isolate* isolate,
+                    v8::Local<v8::Value> value,
+                    const std::vector<v8::Local<v8::ArrayBuffer> >& transfer,
+                    SerializedValue* out) {
+  v8::HandleScope handle_scope(isolate);
+  SerializedValue result;
+  // Transferred ArrayBuffers and SharedArrayBuffers share the transfer ids.
+  internal::SerializerDelegate delegate(
+      isolate, &result, static_cast<uint32_t>(transfer.size()));
+  v8::ValueSerializer serializer(isolate, &delegate);
+  delegate.set_serializer(&serializer);
+
+  for (size_t i = 0; i < transfer.size(); ++i) {
+    if (!transfer[i]->IsNeuterable() ||
+        std::find(transfer.begin(), transfer.begin() + i, transfer[i]) !=
+            transfer.begin() + i) {
+      ThrowCloneError(isolate, "An ArrayBuffer could not be transferred.");
+      return false;
+    }
+    serializer.TransferArrayBuffer(static_cast<uint32_t>(i), transfer[i]);
+  }
+
+  serializer.WriteHeader();
+  if (!serializer.WriteValue(isolate->GetCurrentContext(), value)
+           .FromMaybe(false))
+    return false;
+
+  for (size_t i = 0; i < transfer.size(); ++i)
+    result.array_buffers_.push_back(TakeArrayBuffer(isolate, transfer[i]));
+  std::pair<uint8_t*, size_t> data = serializer.Release();
+  result.data_ = data.first;
+  result.size_ = data.second;
+  *out = std::move(result);
+  return true;
+}
+
+v8::Local<v8::Value> DeserializeValue(v8::Isolate* isolate,
+                                      SerializedValue* value) {
+  if (value->IsEmpty()) {
+    ThrowCloneError(isolate, "The value has already been deserialized.");
+    return v8::Local<v8::Value>();
+  }
+
+  v8::EscapableHandleScope handle_scope(isolate);
+  v8::Local<v8::Context> context = isolate->GetCurrentContext();
+  internal::DeserializerDelegate delegate(value);
+  v8::ValueDeserializer deserializer(isolate, value->data_, value->size_,
+                                     &delegate);
+  delegate.set_deserializer(&deserializer);
+
+  uint32_t id = 0;
+  for (size_t i = 0; i < value->array_buffers_.size(); ++i, ++id) {
+    v8::Local<v8::Value> buffer =
+        ConvertToV8(isolate, value->array_buffers_[i]);
+    if (buffer.IsEmpty() || !buffer->IsArrayBuffer()) {
+      value->Reset();
+      ThrowCloneError(isolate, "An ArrayBuffer could not be transferred.");
+      return v8::Local<v8::Value>();
+    }
+    deserializer.TransferArrayBuffer(id,
+                                     v8::Local<v8::ArrayBuffer>::Cast(buffer));
+  }
+  // Older V8 looks SharedArrayBuffers up among the transferred buffers,
+  // newer V8 asks the delegate.
+  for (size_t i = 0; i < value->shared_array_buffers_.size(); ++i, ++id) {
+    v8::Local<v8::SharedArrayBuffer> buffer =
+        delegate.NewSharedArrayBuffer(isolate, id);
+    if (buffer.IsEmpty()) {
+      value->Reset();
+      ThrowCloneError(isolate,
+                      "The SharedArrayBuffer could not be deserialized.");
+      return v8::Local<v8::Value>();
+    }
+    deserializer.TransferSharedArrayBuffer(id, buffer);
+  }
+
+  v8::Local<v8::Value> result;
+  bool success = deserializer.ReadHeader(context).FromMaybe(false) &&
+                 deserializer.ReadValue(context).ToLocal(&result);
+  value->Reset();
+  if (!success)
+    return v8::Local<v8::Value>();
+  return handle_scope.Escape(result);
+}
+
+}  // namespace mate
+
+#endif  // MATE_V8_AT_LEAST(6, 8)
@@ -0,0 +1,127 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_VALUE_SERIALIZER_H_
+#define NATIVE_MATE_VALUE_SERIALIZER_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/memory/ref_counted.h"
+#include "native_mate/backing_store.h"
+#include "native_mate/converter.h"
+
+namespace mate {
+
+// SerializedObject carries a Wrappable to another isolate inside a
+// SerializedValue, it is returned by Wrappable::Serialize. It holds either a
+// copy of the object's state or the native resources the object gave up.
+class SerializedObject {
+ public:
+  virtual ~SerializedObject() {}
+
+  // Creates the object in |isolate|, where the value is deserialized, and
+  // returns its wrapper, or an empty handle with an exception thrown.
+  virtual v8::Local<v8::Object> Deserialize(v8::Isolate* isolate) = 0;
+};
+
+}  // namespace mate
+
+// SerializedValue needs the ValueSerializer API as of V8 6.8, Wrappables can
+// implement Serialize with any V8.
+#if MATE_V8_AT_LEAST(6, 8)
+
+namespace mate {
+
+namespace internal {
+class DeserializerDelegate;
+class SerializerDelegate;
+}  // namespace internal
+
+// SerializedValue is a JavaScript value in the structured clone format of
+// v8::ValueSerializer, detached from any isolate, so it can be handed to
+// another thread and deserialized in the isolate of a worker:
+//
+//   mate::SerializedValue message;
+//   if (!mate::SerializeValue(isolate, value, transfer, &message))
+//     return;  // An exception was thrown.
+//   worker->PostMessage(std::move(message));
+//
+//   // On the worker's thread.
+//   v8::Local<v8::Value> value = mate::DeserializeValue(isolate, &message);
+//
+// This costs one pass over the value on each side instead of converting it
+// into C++ types and back. The contents of transferred ArrayBuffers and
+// SharedArrayBuffers are not copied, they move to, or are shared with, the
+// other isolate. Wrappables whose Serialize returns a SerializedObject are
+// recreated from it, others fail the serialization.
+//
+// A SerializedValue can be deserialized once.
+class SerializedValue {
+ public:
+  SerializedValue();
+  SerializedValue(SerializedValue&& other);
+  ~SerializedValue();
+
+  SerializedValue& operator=(SerializedValue&& other);
+
+  bool IsEmpty() const { return size_ == 0; }
+
+  // The serialized bytes.
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+  friend class internal::DeserializerDelegate;
+  friend class internal::SerializerDelegate;
+  friend bool SerializeValue(
+      v8::Isolate* isolate,
+      v8::Local<v8::Value> value,
+      const std::vector<v8::Local<v8::ArrayBuffer> >& transfer,
+      SerializedValue* out);
+  friend v8::Local<v8::Value> DeserializeValue(v8::Isolate* isolate,
+                                               SerializedValue* value);
+
+  void Reset();
+
+  // Allocated with realloc by v8::ValueSerializer.
+  uint8_t* data_;
+  size_t size_;
+
+  std::vector<scoped_refptr<BackingStore> > array_buffers_;
+  std::vector<scoped_refptr<BackingStore> > shared_array_buffers_;
+  std::vector<std::unique_ptr<SerializedObject> > objects_;
+
+  DISALLOW_COPY_AND_ASSIGN(SerializedValue);
+};
+
+// Serializes |value| into |out|, in the current context. The ArrayBuffers
+// of |transfer| are transferred: their contents move into |out| and they
+// are detached, other ArrayBuffers are copied. Returns false with an
+// exception thrown when |value| can not be cloned.
+bool SerializeValue(v8::Isolate* isolate,
+                    v8::Local<v8::Value> value,
+                    const std::vector<v8::Local<v8::ArrayBuffer> >& transfer,
+                    SerializedValue* out);
+
+inline bool SerializeValue(v8::Isolate* isolate,
+                           v8::Local<v8::Value> value,
+                           SerializedValue* out) {
+  return SerializeValue(isolate, value,
+                        std::vector<v8::Local<v8::ArrayBuffer> >(), out);
+}
+
+// Recreates the value of |value| in the current context of |isolate| and
+// empties |value|. Returns an empty handle with an exception thrown on
+// failure.
+v8::Local<v8::Value> DeserializeValue(v8::Isolate* isolate,
+                                      SerializedValue* value);
+
+}  // namespace mate
+
+#endif  // MATE_V8_AT_LEAST(6, 8)
+
+#endif  // NATIVE_MATE_VALUE_SERIALIZER_H_
@@ -0,0 +1,131 @@
+// Copyright 2014 Cheng Zhao. All rights reserved.
+// Use of this source code is governed by MIT license that can be found in the
+// LICENSE file.
+
+#ifndef NATIVE_MATE_VARIANT_CONVERTER_H_
+#define NATIVE_MATE_VARIANT_CONVERTER_H_
+
+#include "native_mate/converter.h"
+
+#if MATE_HAS_CXX17
+
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace mate {
+
+namespace internal {
+
+// Tells whether a value has the kind of JavaScript value that Converter<T>
+// accepts, so a variant only tries to convert into the alternatives that can
+// succeed. Types without a specialization accept any kind.
+template<typename T, typename Enable = void>
+struct ValueKind {
+  static bool Matches(v8::Local<v8::Value> val) { return true; }
+};
+
+template<>
+struct ValueKind<bool> {
+  static bool Matches(v8::Local<v8::Value> val) { return val->IsBoolean(); }
+};
+
+template<typename T>
+struct ValueKind<T, std::enable_if_t<std::is_arithmetic<T>::value &&
+                                     !std::is_same<T, bool>::value>> {
+  static bool Matches(v8::Local<v8::Value> val) { return val->IsNumber(); }
+};
+
+template<>
+struct ValueKind<std::string> {
+  static bool Matches(v8::Local<v8::Value> val) { return val->IsString(); }
+};
+
+template<>
+struct ValueKind<v8::Local<v8::Function>> {
+  static bool Matches(v8::Local<v8::Value> val) { return val->IsFunction(); }
+};
+
+template<typename T>
+struct ValueKind<std::vector<T>> {
+  static bool Matches(v8::Local<v8::Value> val) { return val->IsArray(); }
+};
+
+template<typename T>
+struct ValueKind<std::optional<T>> {
+  static bool Matches(v8::Local<v8::Value> val) {
+    return val->IsNullOrUndefined() || ValueKind<T>::Matches(val);
+  }
+};
+
+}  // namespace internal
+
+// An empty std::optional is null in JavaScript, and both undefined and null
+// convert to an empty std::optional. Used as the type of a trailing argument
+// it also accepts a call that leaves the argument out.
+template<typename T>
+struct Converter<std::optional<T>> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::optional<T>& val) {
+    if (!val)
+      return v8::Null(isolate);
+    return Converter<T>::ToV8(isolate, *val);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::optional<T>* out) {
+    if (val->IsNullOrUndefined()) {
+      out->reset();
+      return true;
+    }
+    T value;
+    if (!Converter<T>::FromV8(isolate, val, &value))
+      return false;
+    out->emplace(std::move(value));
+    return true;
+  }
+};
+
+// A std::variant converts its active alternative. From JavaScript the
+// alternatives are tried in order, skipping those whose ValueKind does not
+// match the value, and the first conversion that succeeds is kept. Each
+// alternative is tried at most once.
+template<typename... Ts>
+struct Converter<std::variant<Ts...>> {
+  static v8::Local<v8::Value> ToV8(v8::Isolate* isolate,
+                                    const std::variant<Ts...>& val) {
+    return std::visit(
+        [isolate](const auto& alternative) {
+          return ConvertToV8(isolate, alternative);
+        },
+        val);
+  }
+
+  static bool FromV8(v8::Isolate* isolate,
+                     v8::Local<v8::Value> val,
+                     std::variant<Ts...>* out) {
+    return (TryAlternative<Ts>(isolate, val, out) || ...);
+  }
+
+ private:
+  template<typename T>
+  static bool TryAlternative(v8::Isolate* isolate,
+                             v8::Local<v8::Value> val,
+                             std::variant<Ts...>* out) {
+    if (!internal::ValueKind<T>::Matches(val))
+      return false;
+    T alternative;
+    if (!Converter<T>::FromV8(isolate, val, &alternative))
+      return false;
+    out->template emplace<T>(std::move(alternative));
+    return true;
+  }
+};
+
+}  // namespace mate
+
+#endif  // MATE_HAS_CXX17
+
+#endif  // NATIVE_MATE_VARIANT_CONVERTER_H_
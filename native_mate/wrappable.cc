@@ -7,9 +7,18 @@
 #include "base/logging.h"
 #include "native_mate/dictionary.h"
 #include "native_mate/object_template_builder.h"
+#include "native_mate/private_key.h"
+#include "native_mate/value_serializer.h"
 
 namespace mate {
 
+namespace {
+
+// Tags the wrapper templates of Wrappables, for GetWrappable.
+const PrivateKey kWrappableKey("mate::Wrappable");
+
+}  // namespace
+
 Wrappable::Wrappable() : isolate_(NULL) {
 }
 
@@ -82,8 +91,18 @@ bool Wrappable::IsDestroyed() const {
   return false;
 }
 
+std::unique_ptr<SerializedObject> Wrappable::Serialize(v8::Isolate* isolate) {
+  return NULL;
+}
+
 namespace internal {
 
+void SetUpWrapperTemplate(v8::Isolate* isolate,
+                          v8::Local<v8::ObjectTemplate> templ) {
+  templ->SetInternalFieldCount(1);
+  templ->SetPrivate(kWrappableKey.Get(isolate), v8::True(isolate));
+}
+
 void* FromV8Impl(v8::Isolate* isolate, v8::Local<v8::Value> val) {
   if (!val->IsObject())
     return NULL;
@@ -93,6 +112,17 @@ void* FromV8Impl(v8::Isolate* isolate, v8::Local<v8::Value> val) {
   return MATE_GET_INTERNAL_FIELD_POINTER(obj, 0);
 }
 
+Wrappable* GetWrappable(v8::Isolate* isolate, v8::Local<v8::Value> val) {
+  if (!val->IsObject())
+    return NULL;
+  v8::Local<v8::Object> obj = v8::Local<v8::Object>::Cast(val);
+  if (obj->InternalFieldCount() != 1 ||
+      !obj->HasPrivate(obj->CreationContext(), kWrappableKey.Get(isolate))
+           .FromMaybe(false))
+    return NULL;
+  return static_cast<Wrappable*>(MATE_GET_INTERNAL_FIELD_POINTER(obj, 0));
+}
+
 }  // namespace internal
 
 }  // namespace mate
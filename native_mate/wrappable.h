@@ -5,16 +5,33 @@
 #ifndef NATIVE_MATE_WRAPPABLE_H_
 #define NATIVE_MATE_WRAPPABLE_H_
 
+#include <memory>
+
 #include "native_mate/compat.h"
 #include "native_mate/converter.h"
 #include "native_mate/template_util.h"
 
 namespace mate {
 
+class SerializedObject;
+class Wrappable;
+
 namespace internal {
 
 void* FromV8Impl(v8::Isolate* isolate, v8::Local<v8::Value> val);
 
+// Gives |templ| the internal field of a wrapper and the tag GetWrappable
+// checks. The tag is a private property of the template, so its instances
+// get it when they are created and Wrap adds nothing to them.
+void SetUpWrapperTemplate(v8::Isolate* isolate,
+                          v8::Local<v8::ObjectTemplate> templ);
+
+// Returns the Wrappable of |val|, or NULL when |val| is not the wrapper of
+// one. Unlike FromV8Impl it checks the tag of wrapper templates, so it is
+// safe on objects of other code that also have one internal field. Objects
+// that were created from other templates and passed to Wrap are not tagged.
+Wrappable* GetWrappable(v8::Isolate* isolate, v8::Local<v8::Value> val);
+
 }  // namespace internal
 
 
@@ -69,6 +86,11 @@ class Wrappable {
   static void BuildPrototype(v8::Isolate* isolate,
                              v8::Local<v8::ObjectTemplate> prototype);
 
+  // Called when the wrapper is passed to SerializeValue, subclasses that can
+  // be recreated in another isolate return what DeserializeValue needs for
+  // it. The default returns NULL, which makes the serialization fail.
+  virtual std::unique_ptr<SerializedObject> Serialize(v8::Isolate* isolate);
+
  protected:
   Wrappable();
   virtual ~Wrappable();